@@ -10,6 +10,22 @@
  *
  * \remark  Last Modifications:
  * 			27.12.2013 comments added
+ * 			19.10.2026 asynchronous i2c, simulated sensor (-s, -F)
+ * 			19.10.2026 fast start (-f, -S)
+ * 			19.10.2026 headless capture (-c, -n, -d, -t)
+ * 			19.10.2026 per-channel statistics (-w)
+ * 			19.10.2026 real-time mode (-r), framebuffer mapped once
+ * 			19.10.2026 adaptive sampling rate (-a, -L)
+ * 			19.10.2026 C++ driver benchmark (-b)
+ * 			19.10.2026 shared memory publication (-p, -R, -B)
+ * 			19.10.2026 HDR acquisition (-H)
+ * 			19.10.2026 flicker analysis (-k, -l)
+ * 			19.10.2026 normalization by the batch pipeline, benchmark (-M)
+ * 			19.10.2026 HTTP server with live stream (-W), load generator (-G)
+ * 			19.10.2026 i2c errors reported once by the caller
+ * 			19.10.2026 reads through the C++ driver
+ * 			19.10.2026 exit if the sensor does not answer the init
+ * 			19.10.2026 self checks on the simulated sensor (-T)
  ***************************************************************************
  */
 
@@ -33,7 +49,25 @@
 
 #include <ncurses.h>
 
+#include <sys/resource.h>
+
 #include "TCS3414.h"
+#include "TCS3414_cxx.h"
+#include "i2c_sim.h"
+#include "sensor_state.h"
+#include "check.h"
+#include "capture.h"
+#include "stats.h"
+#include "rt.h"
+#include "adaptive.h"
+#include "bench.h"
+#include "shm.h"
+#include "shm_reader.h"
+#include "hdr.h"
+#include "flicker.h"
+#include "batch.h"
+#include "http.h"
+#include "http_load.h"
 
 /*
  ***************************************************************************
@@ -77,6 +111,12 @@ typedef double FLOAT64;
 
 #define	BPP16		16
 
+/* Period of the console loop: 10 Hz */
+#define LOOP_PERIOD_US	100000
+
+/* Size of the console buffer, one frame is written at once */
+#define CONSOLE_BUFFER_SIZE	8192
+
 /************************************************************************/
 /* VARS									*/
 /************************************************************************/
@@ -90,6 +130,35 @@ INT16 x, y;
 UINT32 fbfd;
 UINT32 screensize;
 
+/* stdout buffer of the console frame */
+char consoleBuffer[CONSOLE_BUFFER_SIZE];
+
+/* Wakeups of the console loop */
+RtJitter loopJitter;
+
+/* Sampling rate controller */
+Adaptive adaptive;
+
+/* The simulated bus, NULL on the real sensor */
+I2cBus *simBus;
+
+/* Cleared by the signal handler to leave the main loop */
+volatile sig_atomic_t running = 1;
+
+/* Last frame read from the sensor */
+TCS3414_Frame frame;
+bool frameBusy;
+bool frameValid;
+UINT32 frameErrors;
+
+/* Statistics of the sensor and the view of the last window */
+Stats stats;
+StatsSet statsWindow;
+
+/* Program start and arrival of the first valid sample */
+UINT64 startUs;
+UINT64 firstValidUs;
+
 /* Function prototype */
 void signal_callback_handler(int signum);
 
@@ -101,13 +170,223 @@ void signal_callback_handler(int signum);
  */
 
 void signal_callback_handler(int signum) {
-	printf("%c[2J", 27);	// clear entire screen
-	printf("%c[f", 27);		// move cursor to upper left of screen ("home")
-	printf("\nExit via Ctrl-C\n");
-	i2c_close();
+	/* Terminate program after the current loop */
+	running = 0;
+}
+
+/*
+ ***************************************************************************
+ * Called from i2c_async_poll() when all four colors of a frame are back
+ ***************************************************************************
+ */
+
+void frame_done(TCS3414_Frame *done, void *arg) {
+	frameBusy = false;
+
+	/* A failed frame is dropped, the last good values stay on screen */
+	if (done->status < 0) {
+		frameErrors++;
+		return;
+	}
+
+	frameValid = true;
+	stats_add(&stats, done->xfer[GREEN].completed, done->color);
+	shm_publish(done->xfer[GREEN].completed, done->color);
+	http_publish(done->xfer[GREEN].completed, done->color);
+
+	/* the steps of the simulated light are known, measure the detection */
+	if (adaptive_update(&adaptive, done->color) && simBus != NULL)
+		adaptive_step_detected(&adaptive, i2c_sim_last_step(simBus),
+				done->xfer[GREEN].completed);
+	if (firstValidUs == 0)
+		firstValidUs = i2c_now_us();
+}
+
+/*
+ ***************************************************************************
+ * Fast start: restore the last good configuration, leave the sensor
+ * alone if it already runs with it and wait for the ADC valid bit
+ * instead of a fixed time. The first sample is read right away.
+ ***************************************************************************
+ */
 
-	/* Terminate program */
-	exit(signum);
+int fast_start(bool restored, bool simulate, const TCS3414_Config *config,
+		UINT16 *sample) {
+	bool reused;
+	int attempt;
+	INT16 status;
+
+	/* the simulated sensor was left running by the last instance */
+	if (simulate && restored)
+		i2c_sim_power_on(i2c_get_bus(), config->timing, config->gain);
+
+	/* try again if the bus glitches, report only when giving up */
+	for (attempt = 0; (status = TCS3414_FastInit(config, &reused)) < 0; attempt++) {
+		if (attempt == 2) {
+			fprintf(stderr, "fast start: %s\n", strerror(-status));
+			return -1;
+		}
+		usleep(10000);
+	}
+
+	/* the first conversion takes one integration time */
+	if (TCS3414_WaitValid(2 * TCS3414_IntegrationUs(config->timing) + 10000) < 0) {
+		fprintf(stderr, "fast start: ADC valid bit not set\n");
+		return -1;
+	}
+
+	fprintf(stderr, "\nFast start: %s configuration, sensor %s\n",
+			restored ? "restored" : "default",
+			reused ? "already running" : "configured");
+
+	/* if this fails the first frame of the main loop is the first sample */
+	if (TCS3414_CxxReadColors(sample) < 0)
+		return 0;
+	firstValidUs = i2c_now_us();
+
+	fprintf(stderr, "First valid sample after %llu us\n\n",
+			firstValidUs - startUs);
+
+	return 0;
+}
+
+/*
+ ***************************************************************************
+ * Start without the fast path: power on the sensor, check that it
+ * echoes POWER_ON and set the configuration if asked to.
+ ***************************************************************************
+ */
+
+int slow_start(bool configure, const TCS3414_Config *config) {
+	int attempt;
+	INT16 status;
+
+	/* try again if the bus glitches, report only when giving up */
+	for (attempt = 0; (status = TCS3414_Init()) < 0; attempt++) {
+		if (attempt == 2) {
+			fprintf(stderr, "init: %s\n", strerror(-status));
+			return -1;
+		}
+		usleep(10000);
+	}
+	printf("\nReceived after sending POWER_ON: 3\n\n");
+
+	if (configure && (status = TCS3414_Configure(config)) < 0) {
+		fprintf(stderr, "configure: %s\n", strerror(-status));
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ ***************************************************************************
+ * Open the framebuffer and map it to user space, once before the loop
+ ***************************************************************************
+ */
+
+int fb_open(void) {
+	// Open framebuffer device file for reading and writing
+	fbfd = open("/dev/fb0", O_RDWR);
+	if (fbfd == -1) {
+		perror("Error: cannot open framebuffer device");
+		return -1;
+	}
+
+	// Get variable screen information
+	if (ioctl(fbfd, FBIOGET_VSCREENINFO, &fbVarScreenInfo) == -1) {
+		perror("Error reading variable information");
+		close(fbfd);
+		return -1;
+	}
+
+	// Figure out the size of the screen in bytes
+	screensize = (fbVarScreenInfo.xres * fbVarScreenInfo.yres
+			* fbVarScreenInfo.bits_per_pixel) / 8;
+
+	// Map the frame buffer device memory to user space.
+	// Starting address in user space is pfb16.
+	if (fbVarScreenInfo.bits_per_pixel == BPP16) {
+		pfb16 = (INT16*) mmap(0, screensize, PROT_READ | PROT_WRITE,
+				MAP_SHARED, fbfd, 0);
+		if (pfb16 == (INT16*) -1) {
+			perror("Error: failed to map 16-BPP framebuffer device to memory");
+			pfb16 = NULL;
+			close(fbfd);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+ ***************************************************************************
+ * Sleep for one loop period. In real-time mode on an absolute timer,
+ * otherwise with usleep() as it always did.
+ ***************************************************************************
+ */
+
+void loop_sleep(bool realtime, struct timespec *next, UINT32 periodUs) {
+	UINT64 requestedUs;
+
+	if (realtime) {
+		rt_add_us(next, periodUs);
+		requestedUs = next->tv_sec * 1000000ULL + next->tv_nsec / 1000;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, next, NULL);
+	} else {
+		requestedUs = i2c_now_us() + periodUs;
+		usleep(periodUs);
+	}
+
+	loopJitter.periodUs = periodUs;
+	rt_jitter_wakeup(&loopJitter, requestedUs, i2c_now_us());
+}
+
+/*
+ ***************************************************************************
+ * Print usage
+ ***************************************************************************
+ */
+
+void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-s] [-F fail:stall:hang:stall_us] [-f] [-S file]\n"
+			"       [-t 12|100|400] [-w seconds] [-r cpu] [-a min_ms:max_ms]\n"
+			"       [-L step_ms] [-b iterations] [-T] [-p] [-W port]\n"
+			"       [-c csv|bin [-n samples] [-d seconds]] [-H bracket]\n"
+			"       [-k period_us] [-l hz:depth[:duty]]\n"
+			"       %s -R seconds | -B readers | -M sensors | [-W port] -G streams\n",
+			name, name);
+	fprintf(stderr, "  -s  use the simulated sensor instead of %s\n",
+			I2C_BUS_DEVICE);
+	fprintf(stderr, "  -F  inject faults on the simulated bus (rates in per mille)\n");
+	fprintf(stderr, "  -f  fast start, do not wait 2 s for the sensor\n");
+	fprintf(stderr, "  -S  state file of the fast start (default %s)\n",
+			SENSOR_STATE_FILE);
+	fprintf(stderr, "  -t  integration time in ms\n");
+	fprintf(stderr, "  -w  length of the statistics window (default %u s)\n",
+			STATS_WINDOW_SECONDS);
+	fprintf(stderr, "  -r  real-time mode: locked memory, SCHED_FIFO, pinned to cpu\n"
+			"      (-1: not pinned)\n");
+	fprintf(stderr, "  -a  adapt the sampling period to the light (default 10 Hz)\n");
+	fprintf(stderr, "  -L  let the simulated light step every step_ms\n");
+	fprintf(stderr, "  -b  benchmark the C and the C++ driver on the simulated sensor\n");
+	fprintf(stderr, "  -T  run the self checks on the simulated sensor\n");
+	fprintf(stderr, "  -p  publish the samples in shared memory (%s)\n", SHM_NAME);
+	fprintf(stderr, "  -R  example reader: print the published samples for some seconds\n");
+	fprintf(stderr, "  -B  benchmark the shared memory with this many readers\n");
+	fprintf(stderr, "  -W  HTTP server with live stream on this port (0: %u)\n",
+			HTTP_DEFAULT_PORT);
+	fprintf(stderr, "  -G  load the HTTP server on localhost with up to this many streams\n");
+	fprintf(stderr, "  -M  benchmark the batch processing of 1 to this many sensors\n");
+	fprintf(stderr, "  -c  headless capture to stdout as CSV or binary records\n");
+	fprintf(stderr, "  -H  HDR capture, bracket ms:gain,... or default (%s)\n",
+			HDR_DEFAULT_BRACKET);
+	fprintf(stderr, "  -k  flicker analysis, sampling the clear channel every period_us\n"
+			"      (0: %u us or longer if the bus is slower), -n counts windows\n"
+			"      of %u samples\n",
+			FLICKER_PERIOD_US, FLICKER_WINDOW);
+	fprintf(stderr, "  -l  let the simulated light flicker (sine, or PWM with duty)\n");
+	fprintf(stderr, "  -n  stop the capture after this many samples\n");
+	fprintf(stderr, "  -d  stop the capture after this many seconds\n");
 }
 
 /*
@@ -185,41 +464,312 @@ int print_rgb(UINT16 red, UINT16 green, UINT16 blue, UINT16 clear) {
  */
 int main(int argc, char *argv[]) {
 	UINT16 green, red, blue, clear;
+	UINT16 sample[4] = { 0, 0, 0, 0 };
+	Batch display;
 	int max = 0;
+	int opt;
+	bool simulate = false;
+	bool fastStart = false;
+	const char *statePath = SENSOR_STATE_FILE;
+	I2cSimFaults faults = { 0, 0, 0, 0, 1 };
+	I2cSimStats simStats;
+	TCS3414_Config config = TCS3414_DEFAULT_CONFIG;
+	int timing = -1;
+	bool restored = false;
+	bool capture = false;
+	CaptureOptions captureOptions = { CAPTURE_CSV, 0, 0.0, 0 };
+	FILE *report;
+	int status = EXIT_SUCCESS;
+	UINT32 windowSeconds = STATS_WINDOW_SECONDS;
+	char title[32];
+	bool realtime = false;
+	INT32 cpu = -1;
+	struct timespec next;
+	bool adapt = false;
+	UINT32 minPeriodMs = 0, maxPeriodMs = 1000, stepMs = 0;
+	bool bench = false;
+	bool check = false;
+	UINT32 benchIterations = 0;
+	bool publish = false;
+	UINT16 httpPort = 0;
+	UINT32 loadStreams = 0;
+	bool hdr = false;
+	HdrBracket bracket;
+	bool flicker = false;
+	UINT32 flickerPeriodUs = 0;
+	FLOAT32 flickerHz = 0.0, flickerDepth = 0.0, flickerDuty = 0.0;
+	struct rusage resources;
+	UINT64 loopStartUs, elapsedUs, cpuUs;
+	I2cAsyncStats i2cStats;
+
+	startUs = i2c_now_us();
+
+	while ((opt = getopt(argc, argv, "sF:fS:t:c:n:d:w:r:a:L:b:TpR:B:M:W:G:H:k:l:")) != -1) {
+		switch (opt) {
+		case 't':
+			switch (atoi(optarg)) {
+			case 12:
+				timing = TCS3414_INTEG_12MS;
+				break;
+			case 100:
+				timing = TCS3414_INTEG_100MS;
+				break;
+			case 400:
+				timing = TCS3414_INTEG_400MS;
+				break;
+			default:
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'c':
+			capture = true;
+			if (strcmp(optarg, "bin") == 0) {
+				captureOptions.format = CAPTURE_BINARY;
+			} else if (strcmp(optarg, "csv") != 0) {
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'n':
+			captureOptions.samples = strtoul(optarg, NULL, 0);
+			break;
+		case 'd':
+			captureOptions.seconds = atof(optarg);
+			break;
+		case 'w':
+			windowSeconds = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			realtime = true;
+			cpu = atoi(optarg);
+			break;
+		case 'a':
+			adapt = true;
+			if (sscanf(optarg, "%u:%u", &minPeriodMs, &maxPeriodMs) < 1) {
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'L':
+			simulate = true;
+			stepMs = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			bench = true;
+			simulate = true;
+			benchIterations = strtoul(optarg, NULL, 0);
+			break;
+		case 'T':
+			check = true;
+			simulate = true;
+			break;
+		case 'H':
+			capture = true;
+			hdr = true;
+			if (hdr_parse(strcmp(optarg, "default") == 0
+					? HDR_DEFAULT_BRACKET : optarg, &bracket) < 0) {
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'k':
+			capture = true;
+			flicker = true;
+			flickerPeriodUs = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			simulate = true;
+			if (sscanf(optarg, "%f:%f:%f", &flickerHz, &flickerDepth,
+					&flickerDuty) < 2) {
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		case 'p':
+			publish = true;
+			break;
+		case 'R':
+			/* the reader does not touch the sensor */
+			exit(shm_reader_run(stdout, SHM_NAME, atof(optarg)) < 0
+					? EXIT_FAILURE : EXIT_SUCCESS);
+		case 'B':
+			exit(shm_bench(stdout, strtoul(optarg, NULL, 0),
+					SHM_BENCH_SECONDS) < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+		case 'W':
+			httpPort = strtoul(optarg, NULL, 0);
+			if (httpPort == 0)
+				httpPort = HTTP_DEFAULT_PORT;
+			break;
+		case 'G':
+			loadStreams = strtoul(optarg, NULL, 0);
+			break;
+		case 'M':
+			exit(batch_bench(stdout, strtoul(optarg, NULL, 0)) < 0
+					? EXIT_FAILURE : EXIT_SUCCESS);
+		case 'f':
+			fastStart = true;
+			break;
+		case 'S':
+			statePath = optarg;
+			break;
+		case 's':
+			simulate = true;
+			break;
+		case 'F':
+			simulate = true;
+			if (sscanf(optarg, "%u:%u:%u:%u", &faults.failPermille,
+					&faults.stallPermille, &faults.hangPermille,
+					&faults.stallUs) < 1) {
+				usage(argv[0]);
+				exit(EXIT_FAILURE);
+			}
+			break;
+		default:
+			usage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* the load generator needs a server running in another process */
+	if (loadStreams)
+		exit(http_load_run(stdout, httpPort ? httpPort : HTTP_DEFAULT_PORT,
+				loadStreams, HTTP_LOAD_SECONDS) < 0
+				? EXIT_FAILURE : EXIT_SUCCESS);
+
+	stats_init(&stats, windowSeconds);
 
 	/* Register signal and signal handler */
 	signal(SIGINT, signal_callback_handler);
 
-	// Open the Linux i2c device
-	i2c_open();
+	// Open the Linux i2c device (or the simulated one)
+	if (simulate) {
+		simBus = i2c_sim_bus_open(&faults);
+		if (simBus != NULL && stepMs)
+			i2c_sim_set_steps(simBus, stepMs * 1000, 2.0);
+		if (simBus != NULL && flickerHz > 0.0)
+			i2c_sim_set_flicker(simBus, flickerHz, flickerDepth, flickerDuty);
+		i2c_use_bus(simBus);
+	} else
+		i2c_open();
+	if (i2c_get_bus() == NULL)
+		exit(EXIT_FAILURE);
 
 	// Set the I2C slave address for all subsequent I2C device transfers
 	i2c_set_address(TCS3414_I2C_ADDR);
 
-	// Configure the TCS3414 color sensor
-	TCS3414_Init();
-
-	/* sleep to let user capture the init message texts */
-	sleep(2);
+	if (bench) {
+		status = bench_driver(stdout, benchIterations) < 0
+				? EXIT_FAILURE : EXIT_SUCCESS;
+		i2c_close();
+		return status;
+	}
+	if (check) {
+		status = check_run(stdout, CHECK_STATE_FILE) < 0
+				? EXIT_FAILURE : EXIT_SUCCESS;
+		i2c_close();
+		return status;
+	}
 
+	/* the capture has no messages to read, it always starts fast */
+	if (capture)
+		fastStart = true;
+
+	if (fastStart)
+		restored = sensor_state_load(statePath, &config) == 0;
+	if (timing >= 0)
+		config.timing = timing;
+
+	if (fastStart) {
+		if (fast_start(restored, simulate, &config, sample) < 0)
+			exit(EXIT_FAILURE);
+		frameValid = true;
+	} else {
+		// Configure the TCS3414 color sensor
+		if (slow_start(timing >= 0, &config) < 0)
+			exit(EXIT_FAILURE);
+
+		/* sleep to let user capture the init message texts */
+		sleep(2);
+	}
 
-	/* endless loop */
-	while (1) {
-		/* read colors from sensor */
-		TCS3414_ReadColor(GREEN, &green);
-		TCS3414_ReadColor(RED, &red);
-		TCS3414_ReadColor(BLUE, &blue);
-		TCS3414_ReadColor(CLEAR, &clear);
+	/* everything the loop uses is set up before it starts */
+	if (!capture) {
+		if (fb_open() < 0 && !simulate)
+			exit(errno);
+		setvbuf(stdout, consoleBuffer, _IOFBF, sizeof(consoleBuffer));
+	}
+	if (publish && shm_publish_open(SHM_NAME) < 0)
+		exit(EXIT_FAILURE);
+	/* before the real-time mode, the server thread must not inherit it */
+	if (httpPort && http_start(httpPort) < 0)
+		exit(EXIT_FAILURE);
+	/* the console is a batch of one sensor, unfiltered */
+	if (batch_init(&display, 1, 1.0) < 0)
+		exit(EXIT_FAILURE);
+	rt_jitter_init(&loopJitter, LOOP_PERIOD_US);
+	adaptive_init(&adaptive, adapt, minPeriodMs * 1000, maxPeriodMs * 1000,
+			LOOP_PERIOD_US, TCS3414_IntegrationUs(config.timing));
+
+	/* the i2c worker started below inherits core and policy */
+	if (realtime && rt_enable(cpu, RT_PRIORITY) < 0)
+		exit(EXIT_FAILURE);
+
+	// Reading the colors is done by the asynchronous i2c engine
+	if (i2c_async_start(i2c_get_bus()) < 0)
+		exit(EXIT_FAILURE);
+
+	/* headless: read once per integration cycle, nothing is drawn */
+	if (capture) {
+		captureOptions.periodUs = TCS3414_IntegrationUs(config.timing);
+		if (hdr) {
+			if (hdr_run(&bracket, &captureOptions, &running) < 0)
+				status = EXIT_FAILURE;
+		} else if (flicker) {
+			captureOptions.periodUs = flickerPeriodUs;
+			if (flicker_run(&captureOptions, &running) < 0)
+				status = EXIT_FAILURE;
+		} else if (capture_run(&captureOptions, &stats, &running) < 0)
+			status = EXIT_FAILURE;
+		running = 0;
+	}
 
-		/* normalize colors (based on empirical values) */
-		red /=1.97;
-		green /= 1.6;
+	/* loop until Ctrl-C */
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	loopStartUs = i2c_now_us();
+	while (running) {
+		/* collect the last frame, keep the last good values on errors */
+		i2c_async_poll();
+		if (frameValid && !frameBusy && frame.status == 0)
+			memcpy(sample, frame.color, sizeof(sample));
+
+		/* start reading colors from sensor, the bus works while we draw */
+		if (!frameBusy && TCS3414_CxxSubmitReadColors(&frame,
+				I2C_ASYNC_TIMEOUT_US, frame_done, NULL) == 0)
+			frameBusy = true;
+
+		/* normalize colors (based on empirical values, see batch.h) */
+		batch_load(&display, 0, sample);
+		batch_process(&display);
+		green = display.out[GREEN][0];
+		red = display.out[RED][0];
+		blue = display.out[BLUE][0];
+		clear = display.out[CLEAR][0];
 
 		/* print colors on console (and keep max value found */
 		max = print_rgb(red, green, blue, clear);
 
-		/* loop frequency: 10 Hz */
-		usleep(100000);
+		/* and the statistics of the last window below */
+		stats_window(&stats, i2c_now_us(), &statsWindow);
+		snprintf(title, sizeof(title), "\nLast %u s", windowSeconds);
+		stats_print(stdout, title, &statsWindow);
+		http_publish_stats(&statsWindow, windowSeconds);
+
+		/* one write for the whole console frame */
+		fflush(stdout);
+
+		/* loop frequency: 10 Hz or as the light requires */
+		loop_sleep(realtime, &next, adaptive.periodUs);
 
 		/* Scale RGB Values to 8 Bit */
 		// max/x=255 --> x = max/255
@@ -229,36 +779,8 @@ int main(int argc, char *argv[]) {
 			blue = blue/(max/255.0);
 		}
 
-		// Open framebuffer device file for reading and writing
-		fbfd = open("/dev/fb0", O_RDWR);
-		if (fbfd == -1) {
-			perror("Error: cannot open framebuffer device");
-			exit(errno);
-		}
-
-		// Get variable screen information
-		if (ioctl(fbfd, FBIOGET_VSCREENINFO, &fbVarScreenInfo) == -1) {
-			perror("Error reading variable information");
-			close(fbfd);
-			exit(errno);
-		}
-
-		// Figure out the size of the screen in bytes
-		screensize = (fbVarScreenInfo.xres * fbVarScreenInfo.yres
-				* fbVarScreenInfo.bits_per_pixel) / 8;
-
-		// Map the frame buffer device memory to user space.
-		// Starting address in user space is pfb16.
-		if (fbVarScreenInfo.bits_per_pixel == BPP16) {
-			pfb16 = (INT16*) mmap(0, screensize, PROT_READ | PROT_WRITE,
-					MAP_SHARED, fbfd, 0);
-			if (pfb16 == (INT16*) -1) {
-				perror(
-						"Error: failed to map 16-BPP framebuffer device to memory");
-				exit(errno);
-			}
-
-			// Fill the screen with 16 bpp, do it for all [x,y] pixel with desired color
+		// Fill the screen with 16 bpp, do it for all [x,y] pixel with desired color
+		if (pfb16 != NULL) {
 			for (y = 0; y < fbVarScreenInfo.yres; y++) {
 				for (x = 0; x < fbVarScreenInfo.xres; x++) {
 					pfb16[x + y * fbVarScreenInfo.xres] = CONVERT_RGB24_16BPP(red, green, blue);
@@ -268,11 +790,61 @@ int main(int argc, char *argv[]) {
 	}
 
 	// Cleanup
-	munmap(pfb16, screensize);
-	close(fbfd);
+	if (pfb16 != NULL) {
+		munmap(pfb16, screensize);
+		close(fbfd);
+	}
+
+	/* the capture owns stdout, everything else goes to stderr */
+	report = capture ? stderr : stdout;
+	if (!capture) {
+		printf("%c[2J", 27);	// clear entire screen
+		printf("%c[f", 27);		// move cursor to upper left of screen ("home")
+		printf("\nExit via Ctrl-C\n");
+	}
 
-	printf("\n");
+	i2c_async_stop();
+	shm_publish_close();
+	http_stop();
+	batch_free(&display);
+	if (!capture) {
+		rt_jitter_print(report, "loop", &loopJitter);
+
+		/* what the sampling rate costs */
+		elapsedUs = i2c_now_us() - loopStartUs;
+		getrusage(RUSAGE_SELF, &resources);
+		cpuUs = resources.ru_utime.tv_sec * 1000000ULL + resources.ru_utime.tv_usec
+				+ resources.ru_stime.tv_sec * 1000000ULL + resources.ru_stime.tv_usec;
+		i2c_async_get_stats(&i2cStats);
+		adaptive_print(report, &adaptive);
+		fprintf(report, "sampling: cpu %.2f %%, bus busy %.3f %%, "
+				"%.1f transfers/s\n", 100.0 * cpuUs / elapsedUs,
+				100.0 * i2cStats.busUs / elapsedUs,
+				i2cStats.batches * 1e6 / elapsedUs);
+	}
+	i2c_async_print_stats(report);
+	fprintf(report, "frames dropped: %u\n", frameErrors);
+	http_print_stats(report);
+	if (!hdr && !flicker)
+		stats_print(report, "\nWhole run", &stats.total);
+	fprintf(report, "\n");
+	if (firstValidUs)
+		fprintf(report, "first valid sample after %llu us\n",
+				firstValidUs - startUs);
+
+	/* remember the configuration for the next fast start */
+	if (fastStart && firstValidUs)
+		sensor_state_save(statePath, &config);
+	if (simulate) {
+		i2c_sim_get_stats(i2c_get_bus(), &simStats);
+		fprintf(report, "sim: %u transfers, %u failed, %u rejected, %u stalled, %u hangs, "
+				"%u recovered, bus blocked %llu us\n", simStats.transfers,
+				simStats.failed, simStats.rejected, simStats.stalled, simStats.hung,
+				simStats.recovered, simStats.stallUs);
+	}
+
+	fprintf(report, "\n");
 	i2c_close();
 
-	return 0;
+	return status;
 }
@@ -10,9 +10,19 @@
  *
  * \remark  Last Modifications:
  *          27.12.2013 comments added
+ *          19.10.2026 i2c over the bus abstraction, asynchronous reads
+ *          19.10.2026 timing/gain configuration, fast start
+ *          19.10.2026 full scale and gain factor for the HDR mode
+ *          19.10.2026 i2c and register access return the errno, no perror
+ *          19.10.2026 ADC disabled before manual integration is selected
+ *          19.10.2026 TCS3414_Init() returns the errno, checks the echo
+ *          19.10.2026 timing and gain always written with ADC_EN at 0
+ *          19.10.2026 i2c_get_address() moved inline into the header
  ***************************************************************************
  */
 
+#include <errno.h>
+
 #include "TCS3414.h"
 
 /*
@@ -21,8 +31,11 @@
  ***************************************************************************
  */
 
-/* File descriptor to i2cdev */
-INT32 i2c_fd;
+/* Bus the sensor is connected to */
+I2cBus *i2c_bus;
+
+/* Slave address of all subsequent transfers */
+UINT8 i2c_address;
 
 /* i2c communication buffer */
 UINT8 i2cCommBuffer[8];
@@ -33,20 +46,34 @@ UINT8 i2cCommBuffer[8];
 
 INT16 i2c_open(void) {
 	/* Open the Linux i2c device */
-	i2c_fd = open("/dev/i2c-1", O_RDWR);
-	if (i2c_fd < 0) {
-		perror("i2cOpen");
+	i2c_bus = i2c_dev_bus_open(I2C_BUS_DEVICE);
+	if (i2c_bus == NULL) {
+		fprintf(stderr, "i2cOpen: cannot open %s\n", I2C_BUS_DEVICE);
 		return -1;
 	}
 	return 0;
 }
 
+/************************************************************************/
+/* Use another bus instead (e.g. the simulated sensor)					*/
+/************************************************************************/
+
+void i2c_use_bus(I2cBus *bus) {
+	i2c_bus = bus;
+}
+
+I2cBus *i2c_get_bus(void) {
+	return i2c_bus;
+}
+
 /************************************************************************/
 /* Close the i2c interface												*/
 /************************************************************************/
 
 void i2c_close(void) {
-	close(i2c_fd);
+	if (i2c_bus != NULL)
+		i2c_bus->close(i2c_bus);
+	i2c_bus = NULL;
 }
 
 /************************************************************************/
@@ -54,74 +81,228 @@ void i2c_close(void) {
 /************************************************************************/
 
 INT16 i2c_set_address(UINT8 i2cAddress) {
-	/* Set the I2C slave address for all subsequent I2C device transfers */
-	if (ioctl(i2c_fd, I2C_SLAVE, i2cAddress) < 0) {
-		perror("i2cSetAddress");
-		return -1;
-	}
+	/* The address is sent with every transfer */
+	i2c_address = i2cAddress;
 	return 0;
 }
 
 /************************************************************************/
-/* Write to the i2c device												*/
+/* Transfer one message to or from the i2c device						*/
+/************************************************************************/
+
+static INT16 i2c_message(UINT8 *i2cBuffer, UINT16 i2cLen, UINT16 flags) {
+	struct i2c_msg msg;
+	INT16 status;
+
+	if (i2c_bus == NULL)
+		return -ENODEV;
+
+	msg.addr = i2c_address;
+	msg.flags = flags;
+	msg.len = i2cLen;
+	msg.buf = i2cBuffer;
+
+	status = i2c_bus->transfer(i2c_bus, &msg, 1);
+	if (status < 0)
+		errno = -status;
+	return status;
+}
+
+/************************************************************************/
+/* Write to the i2c device, 0 or the negative errno (also in errno).	*/
+/* Reporting a failure is up to the caller.								*/
 /************************************************************************/
 
 INT16 i2c_write(UINT8 *i2cBuffer, UINT16 i2cLen) {
-	/* Write to the i2c device */
-	if (write(i2c_fd, i2cBuffer, i2cLen) != i2cLen) {
-		perror("i2cWrite");
-		return -1;
-	}
-	return 0;
+	return i2c_message(i2cBuffer, i2cLen, 0);
 }
 
 /************************************************************************/
-/* Read from the i2c device												*/
+/* Read from the i2c device, 0 or the negative errno (also in errno)	*/
 /************************************************************************/
 
 INT16 i2c_read(UINT8 *i2cBuffer, UINT16 i2cLen) {
-	/* Read from the i2c device */
-	if (read(i2c_fd, i2cBuffer, i2cLen) != i2cLen) {
-		perror("i2cRead");
-		return -1;
-	}
-	return 0;
+	return i2c_message(i2cBuffer, i2cLen, I2C_M_RD);
 }
 
 /************************************************************************/
-/* Initialize the color sensor TCS3414									*/
+/* Initialize the color sensor TCS3414. Returns 0, the negative errno	*/
+/* of the transfer or -EIO if the sensor does not echo POWER_ON.		*/
 /************************************************************************/
 INT16 TCS3414_Init(void) {
+	INT16 status;
+
 	/* Setup i2c buffer for the control register */
 	i2cCommBuffer[0] = TCS3414_BYTE_WISE | TCS3414_CONTROL;
 
 	/* Write buffer data to i2c device */
-	if (i2c_write(i2cCommBuffer, 1) < 0) {
-		perror("i2cInitA");
-		return -1;
-	}
+	status = i2c_write(i2cCommBuffer, 1);
+	if (status < 0)
+		return status;
 
 	/* Setup TCS3414 register to power on and enable ADC converting */
 	i2cCommBuffer[0] = TCS3414_POWER_ON_ADC_EN;
 
 	/* Write buffer data to i2c device */
-	if (i2c_write(i2cCommBuffer, 1) < 0) {
-		perror("i2cInitB");
-		return -1;
-	}
+	status = i2c_write(i2cCommBuffer, 1);
+	if (status < 0)
+		return status;
 
 	/* See datasheet page 15, table 4, note 3: "If a value of 03h is
 	 * written, the value returned during a read cycle will be 03h.
 	 * This feature can be used to verify that the device is
 	 * communicating properly."
 	 */
-	i2c_read(i2cCommBuffer, 1);
+	status = i2c_read(i2cCommBuffer, 1);
+	if (status < 0)
+		return status;
+
+	if ((i2cCommBuffer[0] & TCS3414_POWER_ON_ADC_EN) != TCS3414_POWER_ON_ADC_EN)
+		return -EIO;
+
+	return 0;
+}
+
+/************************************************************************/
+/* Integration time of a TIMING register value in microseconds			*/
+/************************************************************************/
+
+UINT32 TCS3414_IntegrationUs(UINT8 timing) {
+	switch (timing & TCS3414_INTEG_MASK) {
+	case TCS3414_INTEG_100MS:
+		return 100000;
+	case TCS3414_INTEG_400MS:
+		return 400000;
+	default:
+		return 12000;
+	}
+}
+
+/************************************************************************/
+/* Highest count of a channel: slew rate limited for short integration	*/
+/* times, limited by the 16 bit counter for long ones (datasheet p. 4)	*/
+/************************************************************************/
+
+UINT16 TCS3414_FullScale(UINT8 timing) {
+	UINT32 fullScale = TCS3414_IntegrationUs(timing) * TCS3414_COUNTS_PER_US;
+
+	return fullScale < TCS3414_FULL_SCALE ? fullScale : TCS3414_FULL_SCALE;
+}
+
+/************************************************************************/
+/* Gain of a GAIN register value: 1, 4, 16 or 64						*/
+/************************************************************************/
+
+UINT32 TCS3414_GainFactor(UINT8 gain) {
+	return 1 << (2 * ((gain & TCS3414_GAIN_MASK) >> 4));
+}
+
+/************************************************************************/
+/* Write one register (command byte and data in one message)			*/
+/************************************************************************/
+
+static INT16 TCS3414_WriteRegister(UINT8 reg, UINT8 value) {
+	i2cCommBuffer[0] = TCS3414_BYTE_WISE | reg;
+	i2cCommBuffer[1] = value;
+
+	return i2c_write(i2cCommBuffer, 2);
+}
+
+/************************************************************************/
+/* Read one register													*/
+/************************************************************************/
 
-	printf("\nReceived after sending POWER_ON: %d (should be 3)\n\n", i2cCommBuffer[0]);
+static INT16 TCS3414_ReadRegister(UINT8 reg, UINT8 *value) {
+	INT16 status;
 
+	i2cCommBuffer[0] = TCS3414_BYTE_WISE | reg;
+
+	status = i2c_write(i2cCommBuffer, 1);
+	if (status == 0)
+		status = i2c_read(i2cCommBuffer, 1);
+	if (status < 0)
+		return status;
+
+	*value = i2cCommBuffer[0];
 	return 0;
 }
 
+/************************************************************************
+ * Set integration time and gain. The timing register must be written
+ * while ADC_EN is 0 (datasheet, control register note 2), so the ADC
+ * is disabled first. Free running, setting ADC_EN again starts the
+ * first integration with the new values ("Basic Operation"); for the
+ * other modes it is left disabled and the caller starts it.
+ ************************************************************************/
+
+INT16 TCS3414_Configure(const TCS3414_Config *config) {
+	INT16 status;
+
+	status = TCS3414_WriteRegister(TCS3414_CONTROL, TCS3414_POWER_ON);
+	if (status == 0)
+		status = TCS3414_WriteRegister(TCS3414_TIMING, config->timing);
+	if (status == 0)
+		status = TCS3414_WriteRegister(TCS3414_GAIN, config->gain);
+	if (status == 0
+			&& (config->timing & TCS3414_INTEG_MODE_MASK) == TCS3414_INTEG_FREE)
+		status = TCS3414_WriteRegister(TCS3414_CONTROL, TCS3414_POWER_ON_ADC_EN);
+	return status;
+}
+
+/************************************************************************
+ * Initialize the sensor for a fast start. If the sensor is already
+ * powered with the wanted timing and gain (e.g. left running by the
+ * last instance of this program) it is not touched at all, so the
+ * data registers stay valid and no integration cycle is lost.
+ * Otherwise it is configured, which enables the ADC again.
+ * Returns 0 or the negative errno, the caller reports it.
+ ************************************************************************/
+
+INT16 TCS3414_FastInit(const TCS3414_Config *config, bool *reused) {
+	UINT8 control, timing, gain;
+	INT16 status;
+
+	*reused = false;
+
+	status = TCS3414_ReadRegister(TCS3414_CONTROL, &control);
+	if (status == 0)
+		status = TCS3414_ReadRegister(TCS3414_TIMING, &timing);
+	if (status == 0)
+		status = TCS3414_ReadRegister(TCS3414_GAIN, &gain);
+	if (status < 0)
+		return status;
+
+	if ((control & TCS3414_POWER_ON_ADC_EN) == TCS3414_POWER_ON_ADC_EN
+			&& timing == config->timing && gain == config->gain) {
+		*reused = true;
+		return 0;
+	}
+
+	return TCS3414_Configure(config);
+}
+
+/************************************************************************
+ * Poll the ADC valid bit of the control register until the first
+ * integration cycle is complete. Returns 0 as soon as the bit is set
+ * or -1 if it was not set within timeoutUs.
+ ************************************************************************/
+
+INT16 TCS3414_WaitValid(UINT32 timeoutUs) {
+	UINT64 start = i2c_now_us();
+	UINT8 control;
+
+	do {
+		if (TCS3414_ReadRegister(TCS3414_CONTROL, &control) == 0
+				&& (control & TCS3414_ADC_VALID))
+			return 0;
+
+		/* integration is done in steps of at least 12ms */
+		usleep(1000);
+	} while (i2c_now_us() - start < timeoutUs);
+
+	return -1;
+}
+
 /************************************************************************
  * Get all 4 current color values from the TCS3414 sensor. Each has a
  * low and a high byte. The colors are as follows: GREEN, RED, BLUE,
@@ -161,21 +342,23 @@ void TCS3414_ReadColors(UINT16* green, UINT16* red, UINT16* blue, UINT16* clear)
  * and a high byte. The colors are as follows: GREEN, RED, BLUE,
  * CLEAR (defined in an ENUM in TCS3424.h). CLEAR means no color
  * filtering is applied on this sensor, thus simply the birghtness is
- * measured.
+ * measured. Returns 0 or the negative errno, nothing is printed.
  ************************************************************************/
 
-void TCS3414_ReadColor(Color color, UINT16* value) {
+INT16 TCS3414_ReadColor(Color color, UINT16* value) {
 	/* Convert color enum variable to TCS3414 internal address pointer */
 	UINT8 addressPointer = 0x10 + (UINT8)color*2;
+	INT16 status;
 
 	/* Setup TCS3414 register to read LOW byte */
 	i2cCommBuffer[0] = TCS3414_BYTE_WISE | addressPointer;
 
-	/* Write data to i2c device */
-	i2c_write(i2cCommBuffer, 1);
-
-	/* Read the color value block (1 byte) from the device */
-	i2c_read(i2cCommBuffer, 1);
+	/* Write data to i2c device and read the LOW byte */
+	status = i2c_write(i2cCommBuffer, 1);
+	if (status == 0)
+		status = i2c_read(i2cCommBuffer, 1);
+	if (status < 0)
+		return status;
 
 	/* write LOW byte in variable */
 	*value = i2cCommBuffer[0];
@@ -183,12 +366,82 @@ void TCS3414_ReadColor(Color color, UINT16* value) {
 	/* Setup TCS3414 register to read HIGH byte */
 	i2cCommBuffer[0] = TCS3414_BYTE_WISE | (addressPointer + 0x01);
 
-	/* Write data to i2c device */
-	i2c_write(i2cCommBuffer, 1);
-
-	/* Read the color value block (1 byte) from the device */
-	i2c_read(i2cCommBuffer, 1);
+	/* Write data to i2c device and read the HIGH byte */
+	status = i2c_write(i2cCommBuffer, 1);
+	if (status == 0)
+		status = i2c_read(i2cCommBuffer, 1);
+	if (status < 0)
+		return status;
 
 	/* wrtie HIGH byte in variable */
 	*value |= i2cCommBuffer[0] << 8;
+
+	return 0;
+}
+
+/************************************************************************
+ * Completion of one channel of an asynchronous frame. The frame is
+ * complete when all four channels are back. Public so other drivers
+ * of the frame (TCS3414_cxx.cpp) complete it the same way.
+ ************************************************************************/
+
+void TCS3414_ChannelDone(I2cXfer *xfer, INT16 status, void *arg) {
+	TCS3414_Frame *frame = arg;
+	Color color = (Color) (xfer - frame->xfer);
+
+	if (status == 0)
+		frame->color[color] = xfer->rbuf[0] | (xfer->rbuf[1] << 8);
+	else if (frame->status == 0)
+		frame->status = status;
+
+	if (--frame->outstanding == 0 && frame->callback != NULL)
+		frame->callback(frame, frame->arg);
+}
+
+/************************************************************************
+ * Prepare the four transactions of a frame. Each channel is one SMBus
+ * read word: the command byte, then the low and the high byte.
+ ************************************************************************/
+
+void TCS3414_PrepareReadColors(TCS3414_Frame *frame, UINT32 timeoutUs,
+		TCS3414_FrameCallback callback, void *arg) {
+	UINT32 color;
+
+	frame->status = 0;
+	frame->outstanding = 4;
+	frame->callback = callback;
+	frame->arg = arg;
+
+	for (color = GREEN; color <= CLEAR; color++) {
+		I2cXfer *xfer = &frame->xfer[color];
+
+		xfer->addr = i2c_address;
+		xfer->wbuf[0] = TCS3414_WORD_WISE | (TCS3414_DATA1LOW + color * 2);
+		xfer->wlen = 1;
+		xfer->rlen = 2;
+		xfer->timeoutUs = timeoutUs;
+		xfer->retries = I2C_ASYNC_RETRIES;
+		xfer->callback = TCS3414_ChannelDone;
+		xfer->arg = frame;
+	}
+}
+
+/************************************************************************
+ * Start reading all four colors without waiting for the bus. The four
+ * reads go to the bus as one combined transfer. The callback is called
+ * from i2c_async_poll().
+ ************************************************************************/
+
+INT16 TCS3414_SubmitReadColors(TCS3414_Frame *frame, UINT32 timeoutUs,
+		TCS3414_FrameCallback callback, void *arg) {
+	I2cXfer *xfers[4] = { &frame->xfer[GREEN], &frame->xfer[RED],
+			&frame->xfer[BLUE], &frame->xfer[CLEAR] };
+	INT16 status;
+
+	TCS3414_PrepareReadColors(frame, timeoutUs, callback, arg);
+
+	status = i2c_async_submit_batch(xfers, 4);
+	if (status < 0)
+		frame->outstanding = 0;
+	return status;
 }
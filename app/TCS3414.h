@@ -10,6 +10,9 @@
  *
  * \remark  Last Modifications:
  *          27.12.2013 comments added
+ *          19.10.2026 i2c over the bus abstraction, asynchronous reads
+ *          19.10.2026 timing/gain configuration, fast start
+ *          19.10.2026 i2c_get_address() inline for the per frame paths
  ***************************************************************************
  */
 
@@ -17,6 +20,7 @@
 #define TCS3414_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -28,6 +32,13 @@
 
 #include <linux/i2c-dev.h>
 
+#include "i2c_bus.h"
+#include "i2c_async.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* TCS3414 internal Register pointers */
 #define TCS3414_CONTROL		0x00	/* Control Register */
 #define TCS3414_TIMING		0x01	/* Integration Time/Gain Register */
@@ -43,35 +54,82 @@
 #define TCS3414_DATA4HIGH	0x17	/* Clear high Register */
 
 /* TCS3414 COMMAND CONTROL -> to be OR-linked with register pointer */
+#define TCS3414_COMMAND		0x80	/* Select the command register */
 #define TCS3414_BYTE_WISE	0x80
+#define TCS3414_WORD_WISE	0xA0
 #define TCS3414_BLOCK_WISE	0xC0
+#define TCS3414_ADDRESS_MASK	0x1F	/* Register pointer bits */
 
 /* I2C ADDRESS OF TCS3414 DEVICE */
 #define TCS3414_I2C_ADDR 	0x39
 
 /* TCS3414 CONTROL REGISTER DATA */
+#define TCS3414_POWER_ON	0x01
+#define TCS3414_ADC_EN		0x02
 #define TCS3414_POWER_ON_ADC_EN	0x03
+#define TCS3414_ADC_VALID	0x10	/* Set after a completed integration */
+
+/* TCS3414 TIMING REGISTER DATA (free running integration) */
+#define TCS3414_INTEG_12MS	0x00
+#define TCS3414_INTEG_100MS	0x01
+#define TCS3414_INTEG_400MS	0x02
+#define TCS3414_INTEG_MASK	0x03
+
+/* Integration mode: manual means the integration runs while ADC_EN is set */
+#define TCS3414_INTEG_FREE	0x00
+#define TCS3414_INTEG_MANUAL	0x10
+#define TCS3414_INTEG_MODE_MASK	0x30
+
+/* TCS3414 GAIN REGISTER DATA (prescaler 1) */
+#define TCS3414_GAIN_1X		0x00
+#define TCS3414_GAIN_4X		0x10
+#define TCS3414_GAIN_16X	0x20
+#define TCS3414_GAIN_64X	0x30
+#define TCS3414_GAIN_MASK	0x30
+
+/* Maximum value of a data channel */
+#define TCS3414_FULL_SCALE	0xFFFF
+
+/* The ADC count rises by at most this much per us (slew rate limit) */
+#define TCS3414_COUNTS_PER_US	5
+
+/* Integration time and gain of the sensor */
+typedef struct {
+	UINT8 timing;
+	UINT8 gain;
+} TCS3414_Config;
+
+/* Power on configuration (register reset values) */
+#define TCS3414_DEFAULT_CONFIG	{ TCS3414_INTEG_12MS, TCS3414_GAIN_1X }
 
 /* ENUM FOR COLOR */
 typedef enum {GREEN, RED, BLUE, CLEAR} Color;
 
 /*
- ***************************************************************************
- * Define some data types
- ***************************************************************************
+ * Result of an asynchronous read of all four colors. The structure is
+ * owned by the i2c engine until the callback has been called, status
+ * is 0 or the negative errno of the first channel that failed.
  */
+typedef struct TCS3414_Frame TCS3414_Frame;
 
-typedef signed char INT8;
-typedef unsigned char UINT8;
+typedef void (*TCS3414_FrameCallback)(TCS3414_Frame *frame, void *arg);
 
-typedef signed short INT16;
-typedef unsigned short UINT16;
+struct TCS3414_Frame {
+	UINT16  color[4];	/* indexed by Color */
+	INT16   status;
+	UINT8   outstanding;
+	I2cXfer xfer[4];
+	TCS3414_FrameCallback callback;
+	void   *arg;
+};
 
-typedef signed int INT32;
-typedef unsigned int UINT32;
+/* Slave address of all transfers, set with i2c_set_address() */
+extern UINT8 i2c_address;
 
-typedef float FLOAT32;
-typedef double FLOAT64;
+/* Inline, it is read for every frame of the acquisition loops */
+static inline UINT8 i2c_get_address(void) {
+	return i2c_address;
+}
 
 /*
  ***************************************************************************
@@ -80,14 +138,31 @@ typedef double FLOAT64;
  */
 
 extern INT16 i2c_open(void);
+extern void  i2c_use_bus(I2cBus *bus);
+extern I2cBus *i2c_get_bus(void);
 extern void  i2c_close(void);
 extern INT16 i2c_set_address(UINT8 i2cAddress);
 extern INT16 i2c_write(UINT8 *i2cBuffer, UINT16 i2cLen);
 extern INT16 i2c_read(UINT8 *i2cBuffer, UINT16 i2cLen);
 extern INT16 TCS3414_Init(void);
+extern INT16 TCS3414_FastInit(const TCS3414_Config *config, bool *reused);
+extern INT16 TCS3414_Configure(const TCS3414_Config *config);
+extern INT16 TCS3414_WaitValid(UINT32 timeoutUs);
+extern UINT32 TCS3414_IntegrationUs(UINT8 timing);
+extern UINT16 TCS3414_FullScale(UINT8 timing);
+extern UINT32 TCS3414_GainFactor(UINT8 gain);
 extern void  TCS3414_ReadColors(UINT16* green, UINT16* red, UINT16* blue,
 		UINT16* clear);
-extern void  TCS3414_ReadColor(Color color, UINT16* value);
+extern INT16 TCS3414_ReadColor(Color color, UINT16* value);
+extern void  TCS3414_ChannelDone(I2cXfer *xfer, INT16 status, void *arg);
+extern void  TCS3414_PrepareReadColors(TCS3414_Frame *frame, UINT32 timeoutUs,
+		TCS3414_FrameCallback callback, void *arg);
+extern INT16 TCS3414_SubmitReadColors(TCS3414_Frame *frame, UINT32 timeoutUs,
+		TCS3414_FrameCallback callback, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
 
 /* #ifndef TCS3414_H */
 #endif
@@ -0,0 +1,230 @@
+/*
+ ***************************************************************************
+ * \brief   Header-only C++ driver for color sensor TCS3414
+ *	    	The register map is a constexpr description and the color
+ *	    	channels are types. The command bytes of a set of channels
+ *	    	are computed by the compiler, the transaction buffers of a
+ *	    	read are laid out at compile time and reading a channel
+ *	    	that does not exist does not compile.
+ * \file    TCS3414.hpp
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef TCS3414_HPP
+#define TCS3414_HPP
+
+#include <stdint.h>
+
+#include "TCS3414.h"
+
+namespace tcs3414 {
+
+/*
+ ***************************************************************************
+ * Register map
+ ***************************************************************************
+ */
+
+namespace reg {
+	constexpr uint8_t control   = TCS3414_CONTROL;
+	constexpr uint8_t timing    = TCS3414_TIMING;
+	constexpr uint8_t gain      = TCS3414_GAIN;
+	constexpr uint8_t dataFirst = TCS3414_DATA1LOW;
+	constexpr uint8_t dataLast  = TCS3414_DATA4HIGH;
+}
+
+/* SMBus protocols selected by the command byte */
+enum class Protocol : uint8_t {
+	Byte  = TCS3414_BYTE_WISE,
+	Word  = TCS3414_WORD_WISE,
+	Block = TCS3414_BLOCK_WISE
+};
+
+/* Command byte: protocol and register pointer */
+constexpr uint8_t command(Protocol protocol, uint8_t address) {
+	return static_cast<uint8_t>(protocol)
+			| (address & TCS3414_ADDRESS_MASK);
+}
+
+/*
+ ***************************************************************************
+ * Typed channels, there is exactly one type per data register pair
+ ***************************************************************************
+ */
+
+template <Color C>
+struct Channel {
+	static_assert(C >= GREEN && C <= CLEAR, "the TCS3414 has four channels");
+
+	static constexpr Color   color = C;
+	static constexpr uint8_t low   = reg::dataFirst + 2 * C;
+	static constexpr uint8_t high  = low + 1;
+
+	/* one SMBus read word returns low and high byte */
+	static constexpr uint8_t readWord = command(Protocol::Word, low);
+
+	static_assert(high <= reg::dataLast, "channel outside of the register map");
+};
+
+typedef Channel<GREEN> Green;
+typedef Channel<RED>   Red;
+typedef Channel<BLUE>  Blue;
+typedef Channel<CLEAR> Clear;
+
+/* Position of a channel in a channel list, fails if it is not there */
+template <class C, class... List>
+struct IndexOf;
+
+template <class C, class... Rest>
+struct IndexOf<C, C, Rest...> {
+	static constexpr unsigned value = 0;
+};
+
+template <class C, class First, class... Rest>
+struct IndexOf<C, First, Rest...> {
+	static constexpr unsigned value = 1 + IndexOf<C, Rest...>::value;
+};
+
+template <class C>
+struct IndexOf<C> {
+	static_assert(sizeof(C) == 0, "channel is not part of this read set");
+};
+
+/*
+ ***************************************************************************
+ * A set of channels read in one combined transfer
+ ***************************************************************************
+ */
+
+template <class... Channels>
+struct ReadSet {
+	static constexpr unsigned size = sizeof...(Channels);
+
+	static_assert(size > 0, "empty read set");
+	static_assert(2 * size <= I2C_BUS_MAX_MSGS, "read set too large for one transfer");
+	static_assert(size <= 4, "the frame has four transactions");
+
+	/* Result of a read, one value per channel of the set */
+	struct Sample {
+		uint16_t value[size];
+
+		template <class C>
+		uint16_t get() const {
+			return value[IndexOf<C, Channels...>::value];
+		}
+	};
+
+	/*
+	 * Command bytes of the set. Constant initialized (no code runs),
+	 * not const because struct i2c_msg wants a writable buffer.
+	 */
+	static uint8_t *commands() {
+		static uint8_t bytes[size] = { Channels::readWord... };
+		return bytes;
+	}
+
+	/* Fill the transaction of one channel, all but the arguments constant */
+	template <class C>
+	static int prepareChannel(TCS3414_Frame *frame, uint8_t address,
+			UINT32 timeoutUs) {
+		I2cXfer *xfer = &frame->xfer[C::color];
+
+		xfer->addr = address;
+		xfer->wbuf[0] = C::readWord;
+		xfer->wlen = 1;
+		xfer->rlen = 2;
+		xfer->timeoutUs = timeoutUs;
+		xfer->retries = I2C_ASYNC_RETRIES;
+		xfer->callback = TCS3414_ChannelDone;
+		xfer->arg = frame;
+		return 0;
+	}
+
+	/* Fill the transactions of an asynchronous frame (unrolled) */
+	static void prepare(TCS3414_Frame *frame, uint8_t address,
+			UINT32 timeoutUs, TCS3414_FrameCallback callback, void *arg) {
+		frame->status = 0;
+		frame->outstanding = size;
+		frame->callback = callback;
+		frame->arg = arg;
+
+		int expand[] = { prepareChannel<Channels>(frame, address, timeoutUs)... };
+		(void) expand;
+	}
+};
+
+/*
+ ***************************************************************************
+ * Driver on an I2C bus
+ ***************************************************************************
+ */
+
+class Driver {
+public:
+	explicit Driver(I2cBus *bus, uint8_t address = TCS3414_I2C_ADDR)
+		: bus_(bus), address_(address) {
+	}
+
+	/* Read all channels of a set in one combined transfer */
+	template <class... Channels>
+	INT16 read(typename ReadSet<Channels...>::Sample &sample) const {
+		typedef ReadSet<Channels...> Set;
+		struct i2c_msg msgs[2 * Set::size];
+		uint8_t data[2 * Set::size];
+		INT16 status;
+
+		for (unsigned i = 0; i < Set::size; i++) {
+			msgs[2 * i].addr = address_;
+			msgs[2 * i].flags = 0;
+			msgs[2 * i].len = 1;
+			msgs[2 * i].buf = &Set::commands()[i];
+			msgs[2 * i + 1].addr = address_;
+			msgs[2 * i + 1].flags = I2C_M_RD;
+			msgs[2 * i + 1].len = 2;
+			msgs[2 * i + 1].buf = &data[2 * i];
+		}
+
+		status = bus_->transfer(bus_, msgs, 2 * Set::size);
+		if (status < 0)
+			return status;
+
+		for (unsigned i = 0; i < Set::size; i++)
+			sample.value[i] = data[2 * i] | (data[2 * i + 1] << 8);
+		return 0;
+	}
+
+	/* Write one register, the register is checked at compile time */
+	template <uint8_t Register>
+	INT16 write(uint8_t value) const {
+		static_assert(Register < reg::dataFirst, "data registers are read only");
+
+		uint8_t buf[2] = { command(Protocol::Byte, Register), value };
+		struct i2c_msg msg = { address_, 0, 2, buf };
+
+		return bus_->transfer(bus_, &msg, 1);
+	}
+
+	INT16 configure(const TCS3414_Config &config) const {
+		INT16 status = write<reg::timing>(config.timing);
+
+		return status < 0 ? status : write<reg::gain>(config.gain);
+	}
+
+private:
+	I2cBus *bus_;
+	uint8_t address_;
+};
+
+/* All four colors in the order of the Color enum */
+typedef ReadSet<Green, Red, Blue, Clear> AllColors;
+
+} /* namespace tcs3414 */
+
+/* #ifndef TCS3414_HPP */
+#endif
@@ -0,0 +1,89 @@
+/*
+ ***************************************************************************
+ * \brief   C interface of the C++ driver for color sensor TCS3414
+ * \file    TCS3414_cxx.cpp
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 asynchronous submit for the acquisition loops
+ ***************************************************************************
+ */
+
+#include <errno.h>
+
+#include "TCS3414.hpp"
+#include "TCS3414_cxx.h"
+
+using namespace tcs3414;
+
+/************************************************************************/
+/* Read all four colors in one combined transfer (color[GREEN..CLEAR])	*/
+/************************************************************************/
+
+INT16 TCS3414_CxxReadColors(UINT16 *color) {
+	I2cBus *bus = i2c_get_bus();
+	AllColors::Sample sample;
+	INT16 status;
+
+	if (bus == NULL)
+		return -ENODEV;
+
+	status = Driver(bus, i2c_get_address()).read<Green, Red, Blue, Clear>(sample);
+	if (status < 0)
+		return status;
+
+	color[GREEN] = sample.get<Green>();
+	color[RED]   = sample.get<Red>();
+	color[BLUE]  = sample.get<Blue>();
+	color[CLEAR] = sample.get<Clear>();
+	return 0;
+}
+
+/************************************************************************/
+/* Read the clear channel only											*/
+/************************************************************************/
+
+INT16 TCS3414_CxxReadClear(UINT16 *clear) {
+	I2cBus *bus = i2c_get_bus();
+	ReadSet<Clear>::Sample sample;
+	INT16 status;
+
+	if (bus == NULL)
+		return -ENODEV;
+
+	status = Driver(bus, i2c_get_address()).read<Clear>(sample);
+	if (status == 0)
+		*clear = sample.get<Clear>();
+	return status;
+}
+
+/************************************************************************/
+/* Same frame as TCS3414_PrepareReadColors(), for i2c_async_submit_batch */
+/************************************************************************/
+
+void TCS3414_CxxPrepareReadColors(TCS3414_Frame *frame, UINT32 timeoutUs,
+		TCS3414_FrameCallback callback, void *arg) {
+	AllColors::prepare(frame, i2c_get_address(), timeoutUs, callback, arg);
+}
+
+/************************************************************************/
+/* Start reading all four colors without waiting for the bus, like		*/
+/* TCS3414_SubmitReadColors() but with the compile-time frame			*/
+/************************************************************************/
+
+INT16 TCS3414_CxxSubmitReadColors(TCS3414_Frame *frame, UINT32 timeoutUs,
+		TCS3414_FrameCallback callback, void *arg) {
+	I2cXfer *xfers[4] = { &frame->xfer[GREEN], &frame->xfer[RED],
+			&frame->xfer[BLUE], &frame->xfer[CLEAR] };
+	INT16 status;
+
+	AllColors::prepare(frame, i2c_get_address(), timeoutUs, callback, arg);
+
+	status = i2c_async_submit_batch(xfers, 4);
+	if (status < 0)
+		frame->outstanding = 0;
+	return status;
+}
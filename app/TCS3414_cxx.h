@@ -0,0 +1,47 @@
+/*
+ ***************************************************************************
+ * \brief   C interface of the C++ driver for color sensor TCS3414
+ *	    	Lets the C code use the reads of TCS3414.hpp, whose command
+ *	    	bytes and transaction layout are built at compile time. The
+ *	    	device is the one set with i2c_use_bus()/i2c_set_address().
+ *	    	The acquisition reads through these functions, the C
+ *	    	versions in TCS3414.c stay as the reference of the benchmark.
+ * \file    TCS3414_cxx.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 used by the acquisition (fast start, loops, HDR)
+ ***************************************************************************
+ */
+
+#ifndef TCS3414_CXX_H
+#define TCS3414_CXX_H
+
+#include "TCS3414.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 TCS3414_CxxReadColors(UINT16 *color);
+extern INT16 TCS3414_CxxReadClear(UINT16 *clear);
+extern void  TCS3414_CxxPrepareReadColors(TCS3414_Frame *frame,
+		UINT32 timeoutUs, TCS3414_FrameCallback callback, void *arg);
+extern INT16 TCS3414_CxxSubmitReadColors(TCS3414_Frame *frame,
+		UINT32 timeoutUs, TCS3414_FrameCallback callback, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* #ifndef TCS3414_CXX_H */
+#endif
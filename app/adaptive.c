@@ -0,0 +1,138 @@
+/*
+ ***************************************************************************
+ * \brief   Adaptive sampling rate
+ *	    	The level is an exponential average of the clear channel,
+ *	    	the noise floor an exponential average of the absolute
+ *	    	residual. Both only follow stable samples; on a change the
+ *	    	level jumps to the new value.
+ * \file    adaptive.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "adaptive.h"
+
+/************************************************************************/
+/* Round a period to whole integration times (at least one)				*/
+/************************************************************************/
+
+static UINT32 adaptive_round(UINT32 periodUs, UINT32 integUs, bool up) {
+	UINT32 cycles = (periodUs + (up ? integUs - 1 : 0)) / integUs;
+
+	return (cycles ? cycles : 1) * integUs;
+}
+
+/************************************************************************/
+/* Start the controller. Disabled it keeps fixedPeriodUs and only		*/
+/* detects changes, which gives the baseline to compare with.			*/
+/************************************************************************/
+
+void adaptive_init(Adaptive *adaptive, bool enabled, UINT32 minPeriodUs,
+		UINT32 maxPeriodUs, UINT32 fixedPeriodUs, UINT32 integUs) {
+	memset(adaptive, 0, sizeof(*adaptive));
+
+	adaptive->enabled = enabled;
+	adaptive->integUs = integUs;
+	adaptive->minPeriodUs = adaptive_round(minPeriodUs, integUs, true);
+	adaptive->maxPeriodUs = adaptive_round(maxPeriodUs, integUs, false);
+	if (adaptive->maxPeriodUs < adaptive->minPeriodUs)
+		adaptive->maxPeriodUs = adaptive->minPeriodUs;
+
+	/* start in a burst, the light usually changes at startup */
+	adaptive->periodUs = enabled ? adaptive->minPeriodUs : fixedPeriodUs;
+}
+
+/************************************************************************/
+/* Feed a new sample, returns true if it is a change of the light.		*/
+/* adaptive->periodUs is the period to the next sample.					*/
+/************************************************************************/
+
+bool adaptive_update(Adaptive *adaptive, const UINT16 *color) {
+	FLOAT64 x = color[CLEAR], residual, floor;
+
+	adaptive->samples++;
+	adaptive->periodSumUs += adaptive->periodUs;
+
+	if (!adaptive->primed) {
+		adaptive->level = x;
+		adaptive->noise = 0.0;
+		adaptive->primed = true;
+		return false;
+	}
+
+	residual = x - adaptive->level;
+
+	/* below one count or half a percent it is quantization, not noise */
+	floor = adaptive->noise;
+	if (floor < ADAPTIVE_MIN_NOISE * adaptive->level)
+		floor = ADAPTIVE_MIN_NOISE * adaptive->level;
+	if (floor < 1.0)
+		floor = 1.0;
+
+	if (fabs(residual) > ADAPTIVE_THRESHOLD * floor) {
+		adaptive->changes++;
+		adaptive->level = x;
+		adaptive->stable = 0;
+		if (adaptive->enabled)
+			adaptive->periodUs = adaptive->minPeriodUs;
+		return true;
+	}
+
+	adaptive->level += ADAPTIVE_ALPHA * residual;
+	adaptive->noise += ADAPTIVE_ALPHA * (fabs(residual) - adaptive->noise);
+
+	/* back off while the light is stable */
+	if (++adaptive->stable >= ADAPTIVE_STABLE_SAMPLES && adaptive->enabled) {
+		adaptive->stable = 0;
+		adaptive->periodUs *= 2;
+		if (adaptive->periodUs > adaptive->maxPeriodUs)
+			adaptive->periodUs = adaptive->maxPeriodUs;
+	}
+	return false;
+}
+
+/************************************************************************/
+/* A change was detected at detectedUs, the light stepped at stepUs		*/
+/* (known for the simulated sensor). Every step is counted once.		*/
+/************************************************************************/
+
+void adaptive_step_detected(Adaptive *adaptive, UINT64 stepUs,
+		UINT64 detectedUs) {
+	UINT64 latency;
+
+	if (stepUs == 0 || stepUs == adaptive->lastStepUs || detectedUs < stepUs)
+		return;
+
+	latency = detectedUs - stepUs;
+	adaptive->lastStepUs = stepUs;
+	adaptive->steps++;
+	adaptive->stepLatencySumUs += latency;
+	if (latency > adaptive->stepLatencyMaxUs)
+		adaptive->stepLatencyMaxUs = latency;
+}
+
+/************************************************************************/
+/* Print the report														*/
+/************************************************************************/
+
+void adaptive_print(FILE *out, const Adaptive *adaptive) {
+	fprintf(out, "sampling: %s, %llu samples, mean period %.1f ms, "
+			"%u changes\n", adaptive->enabled ? "adaptive" : "fixed rate",
+			adaptive->samples, adaptive->samples
+					? adaptive->periodSumUs / 1000.0 / adaptive->samples : 0.0,
+			adaptive->changes);
+
+	if (adaptive->steps)
+		fprintf(out, "sampling: %u steps detected, latency mean %.1f ms, "
+				"max %.1f ms\n", adaptive->steps,
+				adaptive->stepLatencySumUs / 1000.0 / adaptive->steps,
+				adaptive->stepLatencyMaxUs / 1000.0);
+}
@@ -0,0 +1,77 @@
+/*
+ ***************************************************************************
+ * \brief   Adaptive sampling rate
+ *	    	Watches the clear channel: a change larger than a few times
+ *	    	the noise floor switches to the shortest period (burst),
+ *	    	every run of stable samples doubles the period up to the
+ *	    	longest one. Periods are whole integration times, reading
+ *	    	faster than the sensor converts gives no new data.
+ * \file    adaptive.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "TCS3414.h"
+
+/* A change is a residual above this many times the noise floor */
+#define ADAPTIVE_THRESHOLD	6.0
+
+/* The noise floor never drops below this fraction of the level */
+#define ADAPTIVE_MIN_NOISE	0.005
+
+/* Stable samples before the period is doubled */
+#define ADAPTIVE_STABLE_SAMPLES	8
+
+/* Weight of a new sample in the level and noise averages */
+#define ADAPTIVE_ALPHA		0.125
+
+typedef struct {
+	/* configuration */
+	bool    enabled;	/* false: detect changes but keep the period */
+	UINT32  minPeriodUs;
+	UINT32  maxPeriodUs;
+	UINT32  integUs;
+
+	/* controller state */
+	UINT32  periodUs;
+	FLOAT64 level;		/* smoothed clear channel */
+	FLOAT64 noise;		/* smoothed absolute residual */
+	UINT32  stable;
+	bool    primed;
+
+	/* report */
+	UINT64  samples;
+	UINT64  periodSumUs;
+	UINT32  changes;
+	UINT32  steps;		/* known steps of the light that were detected */
+	UINT64  stepLatencySumUs;
+	UINT64  stepLatencyMaxUs;
+	UINT64  lastStepUs;
+} Adaptive;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern void   adaptive_init(Adaptive *adaptive, bool enabled, UINT32 minPeriodUs,
+		UINT32 maxPeriodUs, UINT32 fixedPeriodUs, UINT32 integUs);
+extern bool   adaptive_update(Adaptive *adaptive, const UINT16 *color);
+extern void   adaptive_step_detected(Adaptive *adaptive, UINT64 stepUs,
+		UINT64 detectedUs);
+extern void   adaptive_print(FILE *out, const Adaptive *adaptive);
+
+/* #ifndef ADAPTIVE_H */
+#endif
@@ -0,0 +1,290 @@
+/*
+ ***************************************************************************
+ * \brief   Batch processing of many sensors
+ *	    	batch_process() runs all stages on BATCH_LANES sensors at a
+ *	    	time with GCC vector types (NEON with -mfpu=neon, SSE on a
+ *	    	PC), keeping the intermediate values in registers.
+ *	    	batch_process_scalar() is the same computation one sensor
+ *	    	at a time, as it used to be done in main().
+ * \file    batch.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 unsafe math only for the vector path
+ ***************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "batch.h"
+
+/* see fft.c, NEON float vectors need unsafe math. Only the vector path
+ * gets it: its sums may be reordered, a rounding of about 1e-7 of the
+ * value, far below the one count (1.5e-5 of full scale) of the input.
+ * The scalar reference stays IEEE exact. */
+#ifdef __arm__
+#define BATCH_UNSAFE_MATH	__attribute__((optimize("unsafe-math-optimizations")))
+#else
+#define BATCH_UNSAFE_MATH
+#endif
+
+typedef FLOAT32 BatchVector __attribute__((vector_size(BATCH_LANES * sizeof(FLOAT32))));
+
+static const FLOAT32 batchNorm[4] = {
+	BATCH_NORM_GREEN, BATCH_NORM_RED, BATCH_NORM_BLUE, BATCH_NORM_CLEAR
+};
+
+/************************************************************************/
+/* Aligned vector load and store										*/
+/************************************************************************/
+
+static inline BATCH_UNSAFE_MATH BatchVector batch_vload(const FLOAT32 *p) {
+	BatchVector v;
+
+	memcpy(&v, __builtin_assume_aligned(p, BATCH_ALIGN), sizeof(v));
+	return v;
+}
+
+static inline BATCH_UNSAFE_MATH void batch_vstore(FLOAT32 *p, BatchVector v) {
+	memcpy(__builtin_assume_aligned(p, BATCH_ALIGN), &v, sizeof(v));
+}
+
+/************************************************************************/
+/* Aligned, zeroed array of one float per sensor						*/
+/************************************************************************/
+
+static FLOAT32 *batch_alloc(UINT32 stride) {
+	void *p;
+
+	if (posix_memalign(&p, BATCH_ALIGN, stride * sizeof(FLOAT32)) != 0)
+		return NULL;
+	memset(p, 0, stride * sizeof(FLOAT32));
+	return p;
+}
+
+/************************************************************************
+ * Set up a batch: no dark offset, the normalization of the cape, the
+ * identity as calibration. alpha is the low pass weight of a new
+ * sample (1 switches the filter off).
+ ************************************************************************/
+
+INT16 batch_init(Batch *batch, UINT32 sensors, FLOAT32 alpha) {
+	UINT32 c, r, i;
+	bool failed = false;
+
+	memset(batch, 0, sizeof(*batch));
+	batch->sensors = sensors;
+	batch->stride = (sensors + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+	batch->alpha = alpha;
+
+	for (c = 0; c < 4; c++) {
+		batch->in[c] = batch_alloc(batch->stride);
+		batch->offset[c] = batch_alloc(batch->stride);
+		batch->scale[c] = batch_alloc(batch->stride);
+		batch->out[c] = batch_alloc(batch->stride);
+		failed |= !batch->in[c] || !batch->offset[c] || !batch->scale[c]
+				|| !batch->out[c];
+		for (r = 0; r < 4; r++) {
+			batch->matrix[r][c] = batch_alloc(batch->stride);
+			failed |= !batch->matrix[r][c];
+		}
+	}
+	if (failed) {
+		perror("batchInit");
+		batch_free(batch);
+		return -1;
+	}
+
+	for (c = 0; c < 4; c++)
+		for (i = 0; i < batch->stride; i++) {
+			batch->scale[c][i] = batchNorm[c];
+			batch->matrix[c][c][i] = 1.0;
+		}
+	return 0;
+}
+
+void batch_free(Batch *batch) {
+	UINT32 c, r;
+
+	for (c = 0; c < 4; c++) {
+		free(batch->in[c]);
+		free(batch->offset[c]);
+		free(batch->scale[c]);
+		free(batch->out[c]);
+		for (r = 0; r < 4; r++)
+			free(batch->matrix[r][c]);
+	}
+	memset(batch, 0, sizeof(*batch));
+}
+
+/************************************************************************/
+/* Calibration of one sensor											*/
+/************************************************************************/
+
+void batch_set_offset(Batch *batch, UINT32 sensor, const FLOAT32 *offset) {
+	UINT32 c;
+
+	for (c = 0; c < 4; c++)
+		batch->offset[c][sensor] = offset[c];
+}
+
+void batch_set_calibration(Batch *batch, UINT32 sensor,
+		const FLOAT32 matrix[4][4]) {
+	UINT32 r, c;
+
+	for (r = 0; r < 4; r++)
+		for (c = 0; c < 4; c++)
+			batch->matrix[r][c][sensor] = matrix[r][c];
+}
+
+/************************************************************************/
+/* Store the raw sample of one sensor									*/
+/************************************************************************/
+
+void batch_load(Batch *batch, UINT32 sensor, const UINT16 *color) {
+	UINT32 c;
+
+	for (c = 0; c < 4; c++)
+		batch->in[c][sensor] = color[c];
+}
+
+/************************************************************************/
+/* Process all sensors, BATCH_LANES at a time							*/
+/************************************************************************/
+
+BATCH_UNSAFE_MATH void batch_process(Batch *batch) {
+	BatchVector x[4], y, o, alpha;
+	UINT32 i, r, c;
+
+	/* the first sample starts the filter */
+	alpha = (BatchVector) { 1.0, 1.0, 1.0, 1.0 };
+	if (batch->primed)
+		alpha *= batch->alpha;
+	batch->primed = true;
+
+	for (i = 0; i < batch->stride; i += BATCH_LANES) {
+		for (c = 0; c < 4; c++)
+			x[c] = (batch_vload(batch->in[c] + i)
+					- batch_vload(batch->offset[c] + i))
+					* batch_vload(batch->scale[c] + i);
+
+		for (r = 0; r < 4; r++) {
+			y = batch_vload(batch->matrix[r][0] + i) * x[0]
+					+ batch_vload(batch->matrix[r][1] + i) * x[1]
+					+ batch_vload(batch->matrix[r][2] + i) * x[2]
+					+ batch_vload(batch->matrix[r][3] + i) * x[3];
+			o = batch_vload(batch->out[r] + i);
+			batch_vstore(batch->out[r] + i, o + alpha * (y - o));
+		}
+	}
+}
+
+/************************************************************************/
+/* Same result, one sensor after the other								*/
+/************************************************************************/
+
+void batch_process_scalar(Batch *batch) {
+	FLOAT32 x[4], y, alpha;
+	UINT32 i, r, c;
+
+	alpha = batch->primed ? batch->alpha : 1.0;
+	batch->primed = true;
+
+	for (i = 0; i < batch->sensors; i++) {
+		for (c = 0; c < 4; c++)
+			x[c] = (batch->in[c][i] - batch->offset[c][i]) * batch->scale[c][i];
+
+		for (r = 0; r < 4; r++) {
+			for (y = 0.0, c = 0; c < 4; c++)
+				y += batch->matrix[r][c][i] * x[c];
+			batch->out[r][i] += alpha * (y - batch->out[r][i]);
+		}
+	}
+}
+
+/************************************************************************/
+/* Time one way of processing, returns ns per sensor sample				*/
+/************************************************************************/
+
+static FLOAT64 batch_time(Batch *batch, void (*process)(Batch *batch),
+		UINT32 rounds) {
+	UINT64 start;
+	UINT32 i;
+
+	process(batch);
+	start = i2c_now_us();
+	for (i = 0; i < rounds; i++)
+		process(batch);
+	return (i2c_now_us() - start) * 1000.0 / rounds / batch->sensors;
+}
+
+/************************************************************************
+ * Process batches of 1, 2, 4 ... maxSensors sensors with a random
+ * calibration and print the time per sensor sample and the sensor
+ * samples per second of one core. Also checks that the vector and the
+ * scalar version agree.
+ ************************************************************************/
+
+INT16 batch_bench(FILE *out, UINT32 maxSensors) {
+	Batch batch, check;
+	FLOAT32 matrix[4][4], offset[4] = { 2.0, 2.0, 2.0, 3.0 };
+	UINT16 color[4];
+	UINT32 sensors, i, r, c, rounds;
+	unsigned int seed = 1;
+	FLOAT64 scalar, vector, error;
+
+	fprintf(out, "batch: sensors   scalar ns   vector ns   vector M samples/s\n");
+	for (sensors = 1; sensors <= maxSensors; sensors *= 2) {
+		if (batch_init(&batch, sensors, 0.25) < 0)
+			return -1;
+		if (batch_init(&check, sensors, 0.25) < 0) {
+			batch_free(&batch);
+			return -1;
+		}
+
+		for (i = 0; i < sensors; i++) {
+			for (r = 0; r < 4; r++) {
+				for (c = 0; c < 4; c++)
+					matrix[r][c] = (r == c) + (rand_r(&seed) % 100 - 50) / 1000.0;
+				color[r] = rand_r(&seed) % TCS3414_FULL_SCALE;
+			}
+			batch_set_calibration(&batch, i, matrix);
+			batch_set_calibration(&check, i, matrix);
+			batch_set_offset(&batch, i, offset);
+			batch_set_offset(&check, i, offset);
+			batch_load(&batch, i, color);
+			batch_load(&check, i, color);
+		}
+
+		/* both give the same result */
+		batch_process(&batch);
+		batch_process(&batch);
+		batch_process_scalar(&check);
+		batch_process_scalar(&check);
+		for (error = 0.0, c = 0; c < 4; c++)
+			for (i = 0; i < sensors; i++)
+				if (fabsf(batch.out[c][i] - check.out[c][i]) > error)
+					error = fabsf(batch.out[c][i] - check.out[c][i]);
+		if (error > 0.01) {
+			fprintf(out, "batch: vector and scalar differ by %f\n", error);
+			batch_free(&batch);
+			batch_free(&check);
+			return -1;
+		}
+
+		rounds = BATCH_BENCH_SAMPLES / sensors;
+		scalar = batch_time(&check, batch_process_scalar, rounds);
+		vector = batch_time(&batch, batch_process, rounds);
+		fprintf(out, "batch: %7u   %9.2f   %9.2f   %18.1f\n", sensors, scalar,
+				vector, 1000.0 / vector);
+
+		batch_free(&batch);
+		batch_free(&check);
+	}
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ ***************************************************************************
+ * \brief   Batch processing of many sensors
+ *	    	The samples of all sensors are stored as structure of arrays:
+ *	    	one aligned array per channel (and per calibration
+ *	    	coefficient), indexed by sensor. Every stage then is one loop
+ *	    	over all sensors that works on whole vectors.
+ *	    	Stages: dark offset and normalization, 4x4 calibration
+ *	    	matrix, first order low pass.
+ * \file    batch.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "TCS3414.h"
+
+/* Normalization of the channels (empirical values of the BBB-BFH-Cape) */
+#define BATCH_NORM_GREEN	(1.0 / 1.6)
+#define BATCH_NORM_RED		(1.0 / 1.97)
+#define BATCH_NORM_BLUE		1.0
+#define BATCH_NORM_CLEAR	1.0
+
+/* Floats per vector, every array is padded to whole vectors */
+#define BATCH_LANES		4
+#define BATCH_ALIGN		16
+
+/* The benchmark processes about this many sensor samples per size */
+#define BATCH_BENCH_SAMPLES	(4 * 1024 * 1024)
+
+typedef struct {
+	UINT32   sensors;
+	UINT32   stride;		/* sensors rounded up to whole vectors */
+	FLOAT32 *in[4];			/* raw counts, indexed by Color */
+	FLOAT32 *offset[4];		/* dark counts */
+	FLOAT32 *scale[4];		/* normalization */
+	FLOAT32 *matrix[4][4];		/* calibration: out[r] = sum matrix[r][c] x[c] */
+	FLOAT32 *out[4];		/* calibrated and filtered values */
+	FLOAT32  alpha;			/* weight of a new sample, 1: no filter */
+	bool     primed;		/* out holds a value, the filter can start */
+} Batch;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 batch_init(Batch *batch, UINT32 sensors, FLOAT32 alpha);
+extern void  batch_free(Batch *batch);
+extern void  batch_set_offset(Batch *batch, UINT32 sensor, const FLOAT32 *offset);
+extern void  batch_set_calibration(Batch *batch, UINT32 sensor,
+		const FLOAT32 matrix[4][4]);
+extern void  batch_load(Batch *batch, UINT32 sensor, const UINT16 *color);
+extern void  batch_process(Batch *batch);
+extern void  batch_process_scalar(Batch *batch);
+extern INT16 batch_bench(FILE *out, UINT32 maxSensors);
+
+/* #ifndef BATCH_H */
+#endif
@@ -0,0 +1,281 @@
+/*
+ ***************************************************************************
+ * \brief   Driver benchmark
+ *	    	Every variant runs the same number of operations, the result
+ *	    	is the mean time per operation. The C++ and the C variant of
+ *	    	each operation must give the same bytes on the bus; this is
+ *	    	checked on a recording bus that answers every read with
+ *	    	data derived from the register, so the check does not depend
+ *	    	on the light or on injected faults.
+ * \file    bench.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 reads checked on a recording bus, TCS3414_ReadColor timed
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "bench.h"
+#include "TCS3414_cxx.h"
+
+/* Messages kept by the recording bus */
+#define BENCH_RECORD_MSGS	32
+
+typedef struct {
+	UINT16 addr;
+	UINT16 flags;
+	UINT16 len;
+	UINT8  command;		/* first byte of a write */
+} BenchMsg;
+
+typedef struct {
+	UINT8    reg;		/* register pointer, kept between transfers */
+	UINT32   transfers;
+	UINT32   count;
+	BenchMsg msg[BENCH_RECORD_MSGS];
+} BenchRecord;
+
+/* Keeps the compiler from dropping the results */
+static volatile UINT32 benchSink;
+
+/* Timed reads that failed (e.g. faults injected with -F) */
+static UINT32 benchFailed;
+
+/************************************************************************/
+/* Monotonic time in nanoseconds										*/
+/************************************************************************/
+
+static UINT64 bench_now_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (UINT64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/************************************************************************/
+/* Hand-written C: the four read words as one combined transfer, the	*/
+/* command bytes computed at runtime as in TCS3414_ReadColor()			*/
+/************************************************************************/
+
+static INT16 bench_c_read_colors(UINT16 *color) {
+	I2cBus *bus = i2c_get_bus();
+	struct i2c_msg msgs[8];
+	UINT8 command[4], data[8];
+	UINT32 i;
+	INT16 status;
+
+	if (bus == NULL)
+		return -ENODEV;
+
+	for (i = GREEN; i <= CLEAR; i++) {
+		command[i] = TCS3414_WORD_WISE | (TCS3414_DATA1LOW + (UINT8) i * 2);
+		msgs[2 * i].addr = i2c_get_address();
+		msgs[2 * i].flags = 0;
+		msgs[2 * i].len = 1;
+		msgs[2 * i].buf = &command[i];
+		msgs[2 * i + 1].addr = i2c_get_address();
+		msgs[2 * i + 1].flags = I2C_M_RD;
+		msgs[2 * i + 1].len = 2;
+		msgs[2 * i + 1].buf = &data[2 * i];
+	}
+
+	status = bus->transfer(bus, msgs, 8);
+	if (status < 0)
+		return status;
+
+	for (i = GREEN; i <= CLEAR; i++)
+		color[i] = data[2 * i] | (data[2 * i + 1] << 8);
+	return 0;
+}
+
+/************************************************************************/
+/* The existing driver path: two byte reads per channel					*/
+/************************************************************************/
+
+static INT16 bench_read_color(UINT16 *color) {
+	UINT32 i;
+	INT16 status;
+
+	for (i = GREEN; i <= CLEAR; i++) {
+		status = TCS3414_ReadColor((Color) i, &color[i]);
+		if (status < 0)
+			return status;
+	}
+	return 0;
+}
+
+/************************************************************************/
+/* Recording bus: keeps the messages, a read returns the register		*/
+/* pointer of the last write and the addresses following it				*/
+/************************************************************************/
+
+static INT16 bench_record_transfer(I2cBus *bus, struct i2c_msg *msgs,
+		UINT32 nmsgs) {
+	BenchRecord *record = bus->priv;
+	BenchMsg *msg;
+	UINT32 i, j;
+
+	record->transfers++;
+	for (i = 0; i < nmsgs; i++) {
+		if (!(msgs[i].flags & I2C_M_RD) && msgs[i].len > 0)
+			record->reg = msgs[i].buf[0] & TCS3414_ADDRESS_MASK;
+		else
+			for (j = 0; j < msgs[i].len; j++)
+				msgs[i].buf[j] = record->reg + j;
+
+		if (record->count < BENCH_RECORD_MSGS) {
+			msg = &record->msg[record->count++];
+			msg->addr = msgs[i].addr;
+			msg->flags = msgs[i].flags;
+			msg->len = msgs[i].len;
+			msg->command = msgs[i].flags & I2C_M_RD ? 0 : msgs[i].buf[0];
+		}
+	}
+	return 0;
+}
+
+static void bench_record(INT16 (*read)(UINT16 *color), UINT16 *color,
+		BenchRecord *record) {
+	I2cBus *saved = i2c_get_bus();
+	I2cBus bus = { "record", bench_record_transfer, NULL, NULL, record };
+
+	memset(record, 0, sizeof(*record));
+	memset(color, 0, 4 * sizeof(*color));
+	i2c_use_bus(&bus);
+	read(color);
+	i2c_use_bus(saved);
+}
+
+/************************************************************************/
+/* The C++ read must put the same bytes on the bus as the C read, and	*/
+/* TCS3414_ReadColor() must give the same colors						*/
+/************************************************************************/
+
+static bool bench_same_read(void) {
+	BenchRecord c, cxx, byteWise;
+	UINT16 colorC[4], colorCxx[4], colorByteWise[4];
+
+	bench_record(bench_c_read_colors, colorC, &c);
+	bench_record(TCS3414_CxxReadColors, colorCxx, &cxx);
+	bench_record(bench_read_color, colorByteWise, &byteWise);
+
+	return c.transfers == 1 && cxx.transfers == 1
+			&& c.count == cxx.count
+			&& memcmp(c.msg, cxx.msg, c.count * sizeof(c.msg[0])) == 0
+			&& memcmp(colorC, colorCxx, sizeof(colorC)) == 0
+			&& memcmp(colorC, colorByteWise, sizeof(colorC)) == 0;
+}
+
+/************************************************************************/
+/* Time one variant, returns ns per operation							*/
+/************************************************************************/
+
+static FLOAT64 bench_reads(INT16 (*read)(UINT16 *color), UINT32 iterations) {
+	UINT16 color[4];
+	UINT64 start;
+	UINT32 i;
+	INT16 status;
+
+	start = bench_now_ns();
+	for (i = 0; i < iterations; i++) {
+		status = read(color);
+		if (status < 0)
+			benchFailed++;
+		else
+			benchSink += color[CLEAR];
+	}
+	return (FLOAT64) (bench_now_ns() - start) / iterations;
+}
+
+static FLOAT64 bench_prepares(void (*prepare)(TCS3414_Frame *frame,
+		UINT32 timeoutUs, TCS3414_FrameCallback callback, void *arg),
+		TCS3414_Frame *frame, UINT32 iterations) {
+	UINT64 start;
+	UINT32 i;
+
+	start = bench_now_ns();
+	for (i = 0; i < iterations; i++) {
+		prepare(frame, I2C_ASYNC_TIMEOUT_US + i, NULL, NULL);
+		benchSink += frame->xfer[CLEAR].wbuf[0];
+	}
+	return (FLOAT64) (bench_now_ns() - start) / iterations;
+}
+
+/************************************************************************/
+/* The C++ frame must be identical to the C frame						*/
+/************************************************************************/
+
+static bool bench_same_frame(void) {
+	TCS3414_Frame c, cxx;
+	UINT32 i;
+
+	memset(&c, 0, sizeof(c));
+	memset(&cxx, 0, sizeof(cxx));
+	TCS3414_PrepareReadColors(&c, I2C_ASYNC_TIMEOUT_US, NULL, &c);
+	TCS3414_CxxPrepareReadColors(&cxx, I2C_ASYNC_TIMEOUT_US, NULL, &c);
+
+	if (c.outstanding != cxx.outstanding)
+		return false;
+	for (i = GREEN; i <= CLEAR; i++)
+		if (c.xfer[i].addr != cxx.xfer[i].addr
+				|| c.xfer[i].wbuf[0] != cxx.xfer[i].wbuf[0]
+				|| c.xfer[i].wlen != cxx.xfer[i].wlen
+				|| c.xfer[i].rlen != cxx.xfer[i].rlen
+				|| c.xfer[i].retries != cxx.xfer[i].retries
+				|| c.xfer[i].callback != cxx.xfer[i].callback)
+			return false;
+	return true;
+}
+
+/************************************************************************
+ * Run the benchmark on the current bus and print ns per operation.
+ * Returns -1 if the C and the C++ driver do not agree.
+ ************************************************************************/
+
+INT16 bench_driver(FILE *out, UINT32 iterations) {
+	TCS3414_Frame frame;
+	FLOAT64 readC, readCxx, readByteWise, prepareC, prepareCxx;
+
+	if (iterations == 0)
+		iterations = BENCH_ITERATIONS;
+
+	if (!bench_same_frame()) {
+		fprintf(out, "bench: C++ frame differs from the C frame\n");
+		return -1;
+	}
+	if (!bench_same_read()) {
+		fprintf(out, "bench: C++ read differs from the C read\n");
+		return -1;
+	}
+
+	memset(&frame, 0, sizeof(frame));
+
+	/* warm up caches and branch predictors, then measure */
+	bench_prepares(TCS3414_PrepareReadColors, &frame, iterations / 10 + 1);
+	prepareC = bench_prepares(TCS3414_PrepareReadColors, &frame, iterations);
+	prepareCxx = bench_prepares(TCS3414_CxxPrepareReadColors, &frame,
+			iterations);
+
+	bench_reads(bench_c_read_colors, iterations / 10 + 1);
+	readC = bench_reads(bench_c_read_colors, iterations);
+	readCxx = bench_reads(TCS3414_CxxReadColors, iterations);
+	readByteWise = bench_reads(bench_read_color, iterations);
+
+	fprintf(out, "bench: %u operations on %s\n", iterations,
+			i2c_get_bus()->name);
+	fprintf(out, "bench: prepare frame   C %7.1f ns   C++ %7.1f ns\n",
+			prepareC, prepareCxx);
+	fprintf(out, "bench: combined read   C %7.1f ns   C++ %7.1f ns\n",
+			readC, readCxx);
+	fprintf(out, "bench: TCS3414_ReadColor() x 4     %7.1f ns\n", readByteWise);
+	if (benchFailed)
+		fprintf(out, "bench: %u reads failed\n", benchFailed);
+	return 0;
+}
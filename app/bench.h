@@ -0,0 +1,36 @@
+/*
+ ***************************************************************************
+ * \brief   Driver benchmark
+ *	    	Compares the hand-written C reads with the C++ driver
+ *	    	(TCS3414.hpp) on the current bus, normally the simulated
+ *	    	sensor, so only the cost of the driver itself is measured.
+ * \file    bench.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+#include "TCS3414.h"
+
+/* Default number of operations per measurement */
+#define BENCH_ITERATIONS	1000000
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 bench_driver(FILE *out, UINT32 iterations);
+
+/* #ifndef BENCH_H */
+#endif
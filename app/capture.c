@@ -0,0 +1,165 @@
+/*
+ ***************************************************************************
+ * \brief   Headless capture
+ *	    	The loop runs on an absolute timer with the integration time
+ *	    	as period. Every period it collects the frame read during
+ *	    	the last period and queues the next one, so the bus transfer
+ *	    	overlaps the wait. stdout is fully buffered with a large
+ *	    	buffer to keep the number of write syscalls low.
+ * \file    capture.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 samples published in shared memory
+ *          19.10.2026 samples and statistics published over HTTP
+ *          19.10.2026 reads through the C++ driver
+ ***************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "capture.h"
+#include "TCS3414_cxx.h"
+#include "shm.h"
+#include "http.h"
+#include "rt.h"
+
+/*
+ ***************************************************************************
+ * Vars
+ ***************************************************************************
+ */
+
+static char captureBuffer[CAPTURE_BUFFER_SIZE];
+
+static TCS3414_Frame captureFrame;
+static bool captureBusy;
+static StatsSet captureWindow;
+
+/************************************************************************/
+/* Called from i2c_async_poll() when the frame is back					*/
+/************************************************************************/
+
+static void capture_frame_done(TCS3414_Frame *frame, void *arg) {
+	captureBusy = false;
+}
+
+/************************************************************************/
+/* Write one record to the (buffered) stdout							*/
+/************************************************************************/
+
+static UINT32 capture_write(CaptureFormat format, UINT64 timeUs,
+		const UINT16 *color) {
+	CaptureRecord record;
+	int len;
+
+	if (format == CAPTURE_BINARY) {
+		record.timeUs = timeUs;
+		memcpy(record.color, color, sizeof(record.color));
+		return fwrite(&record, sizeof(record), 1, stdout) * sizeof(record);
+	}
+
+	len = printf("%llu,%u,%u,%u,%u\n", timeUs, color[GREEN], color[RED],
+			color[BLUE], color[CLEAR]);
+	return len > 0 ? len : 0;
+}
+
+/************************************************************************/
+/* Capture until the sample or time limit is reached or running is		*/
+/* cleared. Every sample is also added to stats (if not NULL). A		*/
+/* throughput summary is printed to stderr.								*/
+/************************************************************************/
+
+INT16 capture_run(const CaptureOptions *options, Stats *stats,
+		volatile sig_atomic_t *running) {
+	struct timespec next;
+	UINT64 start, now, statsUs, bytes = 0;
+	UINT32 samples = 0, dropped = 0, overruns = 0;
+	bool submitted = false;
+	FLOAT64 seconds;
+
+	/* a closed pipe ends the capture instead of killing the process */
+	signal(SIGPIPE, SIG_IGN);
+	setvbuf(stdout, captureBuffer, _IOFBF, sizeof(captureBuffer));
+
+	if (options->format == CAPTURE_CSV)
+		bytes += printf("time_us,green,red,blue,clear\n");
+
+	start = statsUs = i2c_now_us();
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while (*running) {
+		/* collect the frame of the last period */
+		i2c_async_poll();
+		if (submitted && !captureBusy) {
+			submitted = false;
+			if (captureFrame.status == 0) {
+				bytes += capture_write(options->format,
+						captureFrame.xfer[GREEN].completed - start,
+						captureFrame.color);
+				if (stats != NULL)
+					stats_add(stats, captureFrame.xfer[GREEN].completed,
+							captureFrame.color);
+				shm_publish(captureFrame.xfer[GREEN].completed,
+						captureFrame.color);
+				http_publish(captureFrame.xfer[GREEN].completed,
+						captureFrame.color);
+				samples++;
+			} else {
+				dropped++;
+			}
+		} else if (submitted) {
+			/* the bus is slower than the integration time */
+			overruns++;
+		}
+
+		now = i2c_now_us();
+
+		/* the window for the HTTP snapshot, once per second */
+		if (stats != NULL && now - statsUs >= CAPTURE_STATS_US) {
+			stats_window(stats, now, &captureWindow);
+			http_publish_stats(&captureWindow,
+					stats->slotUs * STATS_WINDOW_SLOTS / 1000000);
+			statsUs = now;
+		}
+
+		if ((options->samples && samples >= options->samples)
+				|| (options->seconds && now - start >= options->seconds * 1e6)
+				|| ferror(stdout))
+			break;
+
+		if (!submitted && TCS3414_CxxSubmitReadColors(&captureFrame,
+				options->periodUs, capture_frame_done, NULL) == 0) {
+			captureBusy = true;
+			submitted = true;
+		}
+
+		/* sleep until the next integration cycle is complete */
+		rt_add_us(&next, options->periodUs);
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	/* the engine owns the frame until its deadline at the latest */
+	while (submitted && captureBusy) {
+		usleep(1000);
+		i2c_async_poll();
+	}
+
+	fflush(stdout);
+	seconds = (i2c_now_us() - start) / 1e6;
+
+	fprintf(stderr, "capture: %u samples in %.3f s (%.1f samples/s), "
+			"%u dropped, %u overruns\n", samples, seconds,
+			seconds > 0 ? samples / seconds : 0.0, dropped, overruns);
+	fprintf(stderr, "capture: %llu bytes written (%.1f kB/s)\n", bytes,
+			seconds > 0 ? bytes / seconds / 1000.0 : 0.0);
+
+	return ferror(stdout) ? -1 : 0;
+}
@@ -0,0 +1,60 @@
+/*
+ ***************************************************************************
+ * \brief   Headless capture
+ *	    	Reads the sensor once per integration cycle and writes
+ *	    	timestamped records to stdout, either as CSV or as packed
+ *	    	binary records. Nothing is drawn.
+ * \file    capture.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 statistics period of the HTTP snapshot
+ ***************************************************************************
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <signal.h>
+
+#include "TCS3414.h"
+#include "stats.h"
+
+/* Size of the stdout buffer */
+#define CAPTURE_BUFFER_SIZE	(1024 * 1024)
+
+/* Period of the statistics handed to the HTTP server */
+#define CAPTURE_STATS_US	1000000
+
+typedef enum {CAPTURE_CSV, CAPTURE_BINARY} CaptureFormat;
+
+typedef struct {
+	CaptureFormat format;
+	UINT32  samples;	/* stop after this many samples, 0: no limit */
+	FLOAT64 seconds;	/* stop after this time, 0: no limit */
+	UINT32  periodUs;	/* read period, normally the integration time */
+} CaptureOptions;
+
+/*
+ * Binary record, little endian on the BeagleBone. The timestamp is
+ * relative to the start of the capture.
+ */
+typedef struct __attribute__((packed)) {
+	UINT64 timeUs;
+	UINT16 color[4];	/* indexed by Color */
+} CaptureRecord;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 capture_run(const CaptureOptions *options, Stats *stats,
+		volatile sig_atomic_t *running);
+
+/* #ifndef CAPTURE_H */
+#endif
@@ -0,0 +1,140 @@
+/*
+ ***************************************************************************
+ * \brief   Self checks on the simulated sensor
+ *	    	Regression checks that need no hardware, run with -T. Every
+ *	    	check prints one line and the run fails if one of them
+ *	    	fails. The state file checks write their files next to the
+ *	    	given path and remove them again.
+ * \file    check.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "sensor_state.h"
+#include "i2c_sim.h"
+
+/* Not the power on defaults, so a restored value can be told apart */
+static const TCS3414_Config checkSaved = { TCS3414_INTEG_100MS, TCS3414_GAIN_16X };
+static const TCS3414_Config checkBefore = TCS3414_DEFAULT_CONFIG;
+
+/* State files that must not be loaded */
+static const struct {
+	const char *name;
+	const char *content;
+} checkInvalid[] = {
+	{ "empty file", "" },
+	{ "missing gain", "timing 0x01\n" },
+	{ "missing timing", "gain 0x20\n" },
+	{ "truncated", "timing 0x01\ngai" },
+	{ "truncated value", "timing 0x01\ngain " },
+	{ "corrupt value", "timing 0x01\ngain zz\n" },
+	{ "timing out of range", "timing 0x03\ngain 0x20\n" },
+	{ "gain out of range", "timing 0x01\ngain 0x40\n" },
+	{ "invalid after valid", "timing 0x01\ngain 0x20\ntiming 0x07\n" },
+};
+
+static UINT32 checkFailed;
+
+/************************************************************************/
+/* Print the result of one check										*/
+/************************************************************************/
+
+static void check_report(FILE *out, const char *name, bool ok) {
+	fprintf(out, "check: %-40s %s\n", name, ok ? "ok" : "FAILED");
+	if (!ok)
+		checkFailed++;
+}
+
+static bool check_same(const TCS3414_Config *a, const TCS3414_Config *b) {
+	return a->timing == b->timing && a->gain == b->gain;
+}
+
+static INT16 check_write(const char *path, const char *content) {
+	FILE *file = fopen(path, "w");
+
+	if (file == NULL) {
+		perror("checkWrite");
+		return -1;
+	}
+	fputs(content, file);
+	return fclose(file) == 0 ? 0 : -1;
+}
+
+/************************************************************************/
+/* A file that is not complete and valid leaves the configuration alone	*/
+/************************************************************************/
+
+static void check_state_invalid(FILE *out, const char *path) {
+	TCS3414_Config config;
+	char name[64];
+	UINT32 i;
+
+	for (i = 0; i < sizeof(checkInvalid) / sizeof(checkInvalid[0]); i++) {
+		snprintf(name, sizeof(name), "state: %s", checkInvalid[i].name);
+		config = checkBefore;
+		check_report(out, name, check_write(path, checkInvalid[i].content) == 0
+				&& sensor_state_load(path, &config) < 0
+				&& check_same(&config, &checkBefore));
+	}
+
+	config = checkBefore;
+	remove(path);
+	check_report(out, "state: no file", sensor_state_load(path, &config) < 0
+			&& check_same(&config, &checkBefore));
+}
+
+/************************************************************************/
+/* What sensor_state_save() writes is loaded again and, through the		*/
+/* fast start, ends up in the registers of the simulated sensor			*/
+/************************************************************************/
+
+static void check_state_round_trip(FILE *out, const char *path) {
+	TCS3414_Config config = checkBefore;
+	bool reused;
+
+	check_report(out, "state: round trip", sensor_state_save(path, &checkSaved) == 0
+			&& sensor_state_load(path, &config) == 0
+			&& check_same(&config, &checkSaved));
+
+	/* a sensor left running with other values is configured ... */
+	i2c_sim_power_on(i2c_get_bus(), checkBefore.timing, checkBefore.gain);
+	check_report(out, "state: restored into the sensor",
+			TCS3414_FastInit(&config, &reused) == 0 && !reused
+			&& TCS3414_FastInit(&config, &reused) == 0 && reused);
+
+	/* ... one left running with the restored values is not touched */
+	i2c_sim_power_on(i2c_get_bus(), checkSaved.timing, checkSaved.gain);
+	check_report(out, "state: running sensor reused",
+			TCS3414_FastInit(&config, &reused) == 0 && reused);
+}
+
+/************************************************************************
+ * Run all checks on the current bus, which must be the simulated one.
+ * path is a scratch state file. Returns -1 if a check failed.
+ ************************************************************************/
+
+INT16 check_run(FILE *out, const char *path) {
+	char tmp[256];
+
+	checkFailed = 0;
+
+	check_state_invalid(out, path);
+	check_state_round_trip(out, path);
+
+	/* sensor_state_save() leaves no temporary file behind */
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	check_report(out, "state: no temporary file left", access(tmp, F_OK) < 0);
+	remove(path);
+
+	fprintf(out, "check: %u failed\n", checkFailed);
+	return checkFailed ? -1 : 0;
+}
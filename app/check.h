@@ -0,0 +1,36 @@
+/*
+ ***************************************************************************
+ * \brief   Self checks on the simulated sensor
+ *	    	Checks the behaviour that has to survive changes without
+ *	    	the hardware: invalid state files leave the configuration
+ *	    	alone, a saved configuration is restored into the sensor.
+ * \file    check.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+#include "TCS3414.h"
+
+/* Scratch state file of the checks */
+#define CHECK_STATE_FILE	"/tmp/farbsensor-check.state"
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 check_run(FILE *out, const char *path);
+
+/* #ifndef CHECK_H */
+#endif
@@ -0,0 +1,55 @@
+/*
+ ***************************************************************************
+ * \brief   Real FFT
+ *	    	Radix 2 FFT of a real signal of n samples, done as a complex
+ *	    	FFT of n/2 points with separate real and imaginary arrays.
+ *	    	The butterflies of the larger stages run four at a time on
+ *	    	GCC vector types, which become NEON on the BeagleBone
+ *	    	(-mfpu=neon) and SSE on a PC; without SIMD the compiler
+ *	    	splits them into scalar code.
+ * \file    fft.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdbool.h>
+
+#include "i2c_bus.h"
+
+/* Floats per vector and the alignment of all arrays */
+#define FFT_LANES		4
+#define FFT_ALIGN		16
+
+typedef struct {
+	UINT32   n;		/* real samples, a power of two >= 16 */
+	UINT32   half;		/* complex points */
+	bool     vector;	/* false: scalar butterflies only (reference) */
+	UINT32  *bitrev;	/* bit reversed index of every complex point */
+	FLOAT32 *twRe;		/* twiddles of the stage with span m at [m] */
+	FLOAT32 *twIm;
+	FLOAT32 *postRe;	/* exp(-2 pi i k / n) to split the real FFT */
+	FLOAT32 *postIm;
+	FLOAT32 *re;		/* work arrays */
+	FLOAT32 *im;
+} FftPlan;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 fft_init(FftPlan *plan, UINT32 n);
+extern void  fft_free(FftPlan *plan);
+extern void  fft_real_power(FftPlan *plan, const FLOAT32 *in, FLOAT32 *power);
+
+/* #ifndef FFT_H */
+#endif
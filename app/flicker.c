@@ -0,0 +1,418 @@
+/*
+ ***************************************************************************
+ * \brief   Light flicker analysis
+ *	    	Every sample is one combined transfer: stop the integration,
+ *	    	read the clear channel, start the next integration. The
+ *	    	count is divided by the time since the last transfer, so a
+ *	    	late transfer only makes one integration longer; the window
+ *	    	is resampled to equal steps before the FFT. Windows do not
+ *	    	overlap, the analysis of a window runs while the first
+ *	    	transfer of the next one is on the bus.
+ * \file    flicker.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 first integration started by a rising edge of ADC_EN
+ *          19.10.2026 Hann window built once, amplitude corrections
+ *          19.10.2026 period derived from the measured bus time
+ ***************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+
+#include "flicker.h"
+#include "rt.h"
+
+/* One sample: stop, read clear, start */
+typedef struct {
+	I2cXfer stop;
+	I2cXfer clear;
+	I2cXfer start;
+	UINT32  outstanding;
+	INT16   status;
+} FlickerBatch;
+
+static FlickerBatch flickerBatch;
+
+/* Window, FFT input and spectrum */
+static FLOAT32 flickerSamples[FLICKER_WINDOW];
+static UINT64  flickerTimes[FLICKER_WINDOW];	/* middle of the integration */
+static FLOAT32 flickerUniform[FLICKER_WINDOW];
+static FLOAT32 flickerInput[FLICKER_WINDOW] __attribute__((aligned(FFT_ALIGN)));
+static FLOAT32 flickerPower[FLICKER_WINDOW / 2 + 1];
+static FLOAT32 flickerHann[FLICKER_WINDOW];
+static UINT32  flickerHannLength;	/* built for this many samples */
+
+/* Samples below the minimum quantile, plus one */
+#define FLICKER_EXTREMES	(FLICKER_WINDOW * FLICKER_EXTREME_PERMILLE / 1000 + 1)
+
+/************************************************************************/
+/* Keep the FLICKER_EXTREMES lowest values in low[], sorted ascending	*/
+/************************************************************************/
+
+static void flicker_keep_low(FLOAT32 *low, FLOAT32 x) {
+	UINT32 i = FLICKER_EXTREMES - 1;
+
+	if (x >= low[i])
+		return;
+	for (; i > 0 && low[i - 1] > x; i--)
+		low[i] = low[i - 1];
+	low[i] = x;
+}
+
+/************************************************************************
+ * Analyze one window of samples taken at rateHz. mix is the mean of
+ * frac (1 - frac) over the interpolated samples (0 if they were not
+ * resampled), see flicker_resample().
+ ************************************************************************/
+
+void flicker_analyze(FftPlan *plan, const FLOAT32 *samples, FLOAT64 rateHz,
+		FLOAT64 mix, FlickerResult *result) {
+	FLOAT32 low[FLICKER_EXTREMES], high[FLICKER_EXTREMES];
+	FLOAT64 sum = 0.0, above = 0.0, min, max, a, b, c, delta, leakage;
+	UINT32 i, k, first, peak, n = plan->n;
+
+	memset(result, 0, sizeof(*result));
+	result->rateHz = rateHz;
+
+	/* high[] keeps the highest values as negative lowest values */
+	for (i = 0; i < FLICKER_EXTREMES; i++)
+		low[i] = high[i] = INFINITY;
+	for (i = 0; i < n; i++) {
+		sum += samples[i];
+		flicker_keep_low(low, samples[i]);
+		flicker_keep_low(high, -samples[i]);
+	}
+	result->mean = sum / n;
+	if (sum <= 0.0)
+		return;
+	min = low[FLICKER_EXTREMES - 1];
+	max = -high[FLICKER_EXTREMES - 1];
+
+	for (i = 0; i < n; i++)
+		if (samples[i] > result->mean)
+			above += samples[i] - result->mean;
+	result->percent = 100.0 * (max - min) / (max + min);
+	result->index = above / sum;
+
+	/* without the mean, Hann window against leakage (built once) */
+	if (flickerHannLength != n) {
+		for (i = 0; i < n; i++)
+			flickerHann[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / (n - 1));
+		flickerHannLength = n;
+	}
+	for (i = 0; i < n; i++)
+		flickerInput[i] = (samples[i] - result->mean) * flickerHann[i];
+	fft_real_power(plan, flickerInput, flickerPower);
+
+	first = (UINT32) ceil(FLICKER_MIN_HZ * n / rateHz);
+	if (first < 1)
+		first = 1;
+	for (peak = k = first; k <= n / 2; k++)
+		if (flickerPower[k] > flickerPower[peak])
+			peak = k;
+
+	/* amplitude of a sine in bin peak: 2 |X| / sum of the window (n/2) */
+	result->amplitude = 100.0 * 4.0 * sqrt(flickerPower[peak]) / n
+			/ result->mean;
+	if (result->amplitude < FLICKER_MIN_AMPLITUDE)
+		return;
+
+	/* offset of the frequency from the peak bin: a sine delta bins
+	 * beside the peak gives the larger neighbour r = (1 + delta) /
+	 * (2 - delta) times the peak in the Hann window, so delta is
+	 * (2 r - 1) / (r + 1). A parabola underestimates it. */
+	delta = 0.0;
+	if (peak > first && peak < n / 2) {
+		a = sqrt(flickerPower[peak - 1]);
+		b = sqrt(flickerPower[peak]);
+		c = sqrt(flickerPower[peak + 1]);
+		if (c > a)
+			delta = (2.0 * c - b) / (c + b);
+		else
+			delta = -(2.0 * a - b) / (a + b);
+		if (fabs(delta) > 0.5)
+			delta = 0.0;
+	}
+	result->dominantHz = (peak + delta) * rateHz / n;
+
+	/* a frequency between two bins shows smaller in the Hann window */
+	if (delta != 0.0) {
+		leakage = sin(M_PI * delta) / (M_PI * delta) / (1.0 - delta * delta);
+		result->amplitude /= fabs(leakage);
+	}
+
+	/* every sample integrates over a whole period, which averages a
+	 * sine of frequency f down by sinc(f / rate). Interpolating between
+	 * two samples with phase step theta keeps 1 - 2 frac (1 - frac)
+	 * (1 - cos theta) of its power. */
+	a = M_PI * result->dominantHz / rateHz;
+	result->amplitude *= a / sin(a)
+			/ sqrt(1.0 - 2.0 * mix * (1.0 - cos(2.0 * a)));
+}
+
+/************************************************************************/
+/* Linear interpolation of the window to n equal steps, returns the		*/
+/* mean of frac (1 - frac) for flicker_analyze()						*/
+/************************************************************************/
+
+static FLOAT64 flicker_resample(const UINT64 *times, const FLOAT32 *in,
+		FLOAT32 *out, UINT32 n) {
+	FLOAT64 step = (FLOAT64) (times[n - 1] - times[0]) / (n - 1), t, frac;
+	FLOAT64 mix = 0.0;
+	UINT32 i, j = 0;
+
+	for (i = 0; i < n; i++) {
+		t = times[0] + i * step;
+		while (j < n - 2 && times[j + 1] < t)
+			j++;
+		frac = (t - times[j]) / (FLOAT64) (times[j + 1] - times[j]);
+		out[i] = in[j] + frac * (in[j + 1] - in[j]);
+		mix += frac * (1.0 - frac);
+	}
+	return mix / n;
+}
+
+/************************************************************************/
+/* Cost of the FFT of one window, scalar and vector butterflies			*/
+/************************************************************************/
+
+void flicker_bench(FILE *out, FftPlan *plan) {
+	UINT64 start, us[2];
+	UINT32 i, run;
+	bool vector = plan->vector;
+
+	for (i = 0; i < plan->n; i++)
+		flickerInput[i] = sin(0.1 * i) + 0.001 * i;
+
+	for (run = 0; run < 2; run++) {
+		plan->vector = run;
+		fft_real_power(plan, flickerInput, flickerPower);
+		start = i2c_now_us();
+		for (i = 0; i < FLICKER_BENCH_RUNS; i++)
+			fft_real_power(plan, flickerInput, flickerPower);
+		us[run] = i2c_now_us() - start;
+	}
+	plan->vector = vector;
+
+	fprintf(out, "flicker: FFT of %u samples: scalar %.1f us, vector %.1f us "
+			"per window\n", plan->n, (FLOAT64) us[0] / FLICKER_BENCH_RUNS,
+			(FLOAT64) us[1] / FLICKER_BENCH_RUNS);
+}
+
+/************************************************************************/
+/* Completion of the parts of a sample, called from i2c_async_poll()	*/
+/************************************************************************/
+
+static void flicker_xfer_done(I2cXfer *xfer, INT16 status, void *arg) {
+	FlickerBatch *batch = arg;
+
+	if (status < 0 && batch->status == 0)
+		batch->status = status;
+	batch->outstanding--;
+}
+
+static void flicker_prepare_xfer(I2cXfer *xfer, UINT8 command, UINT8 value,
+		UINT16 rlen, UINT32 timeoutUs) {
+	xfer->addr = i2c_get_address();
+	xfer->wbuf[0] = command;
+	xfer->wbuf[1] = value;
+	xfer->wlen = rlen ? 1 : 2;
+	xfer->rlen = rlen;
+	xfer->timeoutUs = timeoutUs;
+	xfer->retries = 0;	/* a late sample is worse than a lost one */
+	xfer->callback = flicker_xfer_done;
+	xfer->arg = &flickerBatch;
+}
+
+/************************************************************************/
+/* Queue one sample (or only the start of the first integration)		*/
+/************************************************************************/
+
+static INT16 flicker_submit(bool sample, UINT32 timeoutUs) {
+	FlickerBatch *batch = &flickerBatch;
+	I2cXfer *xfers[3];
+	UINT32 count = 0;
+
+	batch->status = 0;
+	if (sample) {
+		flicker_prepare_xfer(&batch->stop, TCS3414_BYTE_WISE | TCS3414_CONTROL,
+				TCS3414_POWER_ON, 0, timeoutUs);
+		flicker_prepare_xfer(&batch->clear,
+				TCS3414_WORD_WISE | TCS3414_DATA4LOW, 0, 2, timeoutUs);
+		xfers[count++] = &batch->stop;
+		xfers[count++] = &batch->clear;
+	}
+	flicker_prepare_xfer(&batch->start, TCS3414_BYTE_WISE | TCS3414_CONTROL,
+			TCS3414_POWER_ON_ADC_EN, 0, timeoutUs);
+	xfers[count++] = &batch->start;
+
+	batch->outstanding = count;
+	return i2c_async_submit_batch(xfers, count);
+}
+
+static INT16 flicker_wait(void) {
+	while (flickerBatch.outstanding) {
+		usleep(100);
+		i2c_async_poll();
+	}
+	return flickerBatch.status;
+}
+
+/************************************************************************/
+/* Set manual integration (TCS3414_Configure() leaves ADC_EN at 0) and	*/
+/* start the first one with the rising edge of ADC_EN. Then time a few	*/
+/* whole samples from the submission to the completion (the deadline	*/
+/* of a sample counts from there), the last one starts the integration.	*/
+/************************************************************************/
+
+static INT16 flicker_setup(UINT32 *busUs) {
+	TCS3414_Config config = { TCS3414_INTEG_MANUAL, FLICKER_GAIN };
+	FlickerBatch *batch = &flickerBatch;
+	UINT32 attempt, run;
+	UINT64 us;
+
+	for (attempt = 0; attempt < 3; attempt++) {
+		if (TCS3414_Configure(&config) == 0 && flicker_submit(false,
+				I2C_ASYNC_TIMEOUT_US) == 0 && flicker_wait() == 0)
+			break;
+		usleep(10000);
+	}
+	if (attempt == 3)
+		return -1;
+
+	*busUs = UINT32_MAX;
+	for (run = 0; run < FLICKER_BUS_RUNS; run++) {
+		if (flicker_submit(true, I2C_ASYNC_TIMEOUT_US) < 0
+				|| flicker_wait() < 0)
+			return -1;
+		us = batch->start.completed - batch->stop.submitted;
+		if (us < *busUs)
+			*busUs = us;
+	}
+	return 0;
+}
+
+/************************************************************************
+ * Sample every options->periodUs until the window or time limit is
+ * reached (options->samples counts windows) or running is cleared. One
+ * CSV line per window goes to stdout, the report to stderr.
+ ************************************************************************/
+
+INT16 flicker_run(const CaptureOptions *options,
+		volatile sig_atomic_t *running) {
+	FftPlan plan;
+	FlickerResult result;
+	struct timespec next;
+	UINT64 start, lastUs, now, fftUs, fftSumUs = 0, fftMaxUs = 0;
+	UINT32 periodUs, busUs, minUs;
+	UINT32 filled = 0, windows = 0, lost = 0, overruns = 0, count;
+	bool submitted = false;
+	FLOAT64 seconds, mix;
+
+	if (fft_init(&plan, FLICKER_WINDOW) < 0)
+		return -1;
+	flicker_bench(stderr, &plan);
+
+	if (flicker_setup(&busUs) < 0) {
+		fprintf(stderr, "flicker: could not start manual integration\n");
+		fft_free(&plan);
+		return -1;
+	}
+
+	/* a shorter period could never be met, every sample would be late */
+	minUs = busUs + busUs * FLICKER_BUS_MARGIN_PERCENT / 100;
+	periodUs = options->periodUs;
+	if (periodUs == 0)
+		periodUs = minUs > FLICKER_PERIOD_US ? minUs : FLICKER_PERIOD_US;
+	fprintf(stderr, "flicker: a sample takes %u us, period %u us\n",
+			busUs, periodUs);
+	if (periodUs < minUs) {
+		fprintf(stderr, "flicker: period below %u us\n", minUs);
+		fft_free(&plan);
+		return -1;
+	}
+	lastUs = flickerBatch.start.started;
+
+	signal(SIGPIPE, SIG_IGN);
+	printf("time_s,rate_hz,dominant_hz,amplitude_pct,percent_flicker,"
+			"flicker_index,fft_us\n");
+
+	start = i2c_now_us();
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while (*running) {
+		/* collect the sample of the last period */
+		i2c_async_poll();
+		if (submitted && flickerBatch.outstanding == 0) {
+			submitted = false;
+			/* the start of the transfer is closest to the stop, the
+			 * completion may be late if the worker was preempted */
+			now = flickerBatch.stop.started;
+			count = flickerBatch.clear.rbuf[0] | (flickerBatch.clear.rbuf[1] << 8);
+			if (flickerBatch.status == 0 && now > lastUs) {
+				/* counts per ms of this integration */
+				flickerSamples[filled] = count * 1000.0 / (now - lastUs);
+				flickerTimes[filled++] = lastUs + (now - lastUs) / 2;
+			} else
+				lost++;
+			lastUs = flickerBatch.start.started;
+		} else if (submitted) {
+			overruns++;
+		}
+
+		/* the next integration ends with the next transfer */
+		if (!submitted && flicker_submit(true, periodUs) == 0)
+			submitted = true;
+
+		if (filled == FLICKER_WINDOW) {
+			fftUs = i2c_now_us();
+			mix = flicker_resample(flickerTimes, flickerSamples,
+					flickerUniform, FLICKER_WINDOW);
+			flicker_analyze(&plan, flickerUniform,
+					(FLICKER_WINDOW - 1) * 1e6 / (flickerTimes[FLICKER_WINDOW - 1]
+							- flickerTimes[0]), mix, &result);
+			fftUs = i2c_now_us() - fftUs;
+			fftSumUs += fftUs;
+			if (fftUs > fftMaxUs)
+				fftMaxUs = fftUs;
+
+			printf("%.3f,%.1f,%.2f,%.2f,%.2f,%.4f,%llu\n",
+					(flickerTimes[FLICKER_WINDOW - 1] - start) / 1e6, result.rateHz,
+					result.dominantHz, result.amplitude, result.percent,
+					result.index, fftUs);
+			fflush(stdout);
+			filled = 0;
+			windows++;
+		}
+
+		now = i2c_now_us();
+		if ((options->samples && windows >= options->samples)
+				|| (options->seconds && now - start >= options->seconds * 1e6)
+				|| ferror(stdout))
+			break;
+
+		rt_add_us(&next, periodUs);
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	/* the engine owns the batch until its deadline at the latest */
+	if (submitted)
+		flicker_wait();
+	fft_free(&plan);
+	seconds = (i2c_now_us() - start) / 1e6;
+
+	fprintf(stderr, "flicker: %u windows in %.3f s, %u samples lost, "
+			"%u overruns\n", windows, seconds, lost, overruns);
+	fprintf(stderr, "flicker: analysis %.1f us per window (max %llu us)\n",
+			windows ? (FLOAT64) fftSumUs / windows : 0.0, fftMaxUs);
+
+	return ferror(stdout) ? -1 : 0;
+}
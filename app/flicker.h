@@ -0,0 +1,80 @@
+/*
+ ***************************************************************************
+ * \brief   Light flicker analysis
+ *	    	Samples the clear channel with manual integration (the
+ *	    	integration runs from one transfer to the next) as fast as
+ *	    	the bus allows, into fixed windows. Every window gives the
+ *	    	dominant flicker frequency (FFT), the percent flicker and
+ *	    	the flicker index.
+ * \file    flicker.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 flicker_analyze() gets the resampling mix
+ *          19.10.2026 period not shorter than a sample on the bus
+ ***************************************************************************
+ */
+
+#ifndef FLICKER_H
+#define FLICKER_H
+
+#include <signal.h>
+
+#include "TCS3414.h"
+#include "capture.h"
+#include "fft.h"
+
+/* Samples per window, a power of two */
+#define FLICKER_WINDOW		1024
+
+/* Default sample period, Nyquist frequency 500 Hz, if the bus is fast
+ * enough: a sample is about 11 bytes, over 1 ms at 100 kHz */
+#define FLICKER_PERIOD_US	1000
+
+/* The period is at least this much longer than a sample takes from
+ * the submission to the completion, measured at the start */
+#define FLICKER_BUS_MARGIN_PERCENT	25
+#define FLICKER_BUS_RUNS	3
+
+/* About 1000 counts per ms at the simulated level, full scale is 5000 */
+#define FLICKER_GAIN		TCS3414_GAIN_16X
+
+/* Slower changes are not flicker */
+#define FLICKER_MIN_HZ		2.0
+
+/* A component below this amplitude (percent of the mean) is noise */
+#define FLICKER_MIN_AMPLITUDE	1.0
+
+/* Minimum and maximum are taken at these quantiles (per mille), so a
+ * single late sample does not make flicker */
+#define FLICKER_EXTREME_PERMILLE	5
+
+/* FFTs per variant in the benchmark at startup */
+#define FLICKER_BENCH_RUNS	200
+
+typedef struct {
+	FLOAT64 rateHz;		/* achieved sample rate */
+	FLOAT64 mean;		/* counts per ms */
+	FLOAT64 dominantHz;	/* 0 if there is no flicker */
+	FLOAT64 amplitude;	/* of the dominant frequency, percent of the mean */
+	FLOAT64 percent;	/* 100 (max - min) / (max + min), see above */
+	FLOAT64 index;		/* area above the mean / total area */
+} FlickerResult;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern void  flicker_analyze(FftPlan *plan, const FLOAT32 *samples,
+		FLOAT64 rateHz, FLOAT64 mix, FlickerResult *result);
+extern void  flicker_bench(FILE *out, FftPlan *plan);
+extern INT16 flicker_run(const CaptureOptions *options,
+		volatile sig_atomic_t *running);
+
+/* #ifndef FLICKER_H */
+#endif
@@ -0,0 +1,397 @@
+/*
+ ***************************************************************************
+ * \brief   HDR acquisition
+ *	    	Pipelined: one combined transfer reads the frame of the
+ *	    	current setting and writes the next setting with ADC_EN at 0,
+ *	    	then sets ADC_EN, which starts the integration. The merge
+ *	    	runs while the next frame integrates, so the bus is touched
+ *	    	once per frame. The datasheet does not say when the first
+ *	    	frame after a change is complete or whether ADC_VALID is
+ *	    	cleared, so the first cycle is discarded: a bracket takes two
+ *	    	integration times per setting plus one transfer each.
+ * \file    hdr.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 frame prepared by the C++ driver
+ *          19.10.2026 setting written with ADC_EN at 0, first cycle discarded
+ ***************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "hdr.h"
+#include "TCS3414_cxx.h"
+#include "rt.h"
+
+/* One frame: ADC valid bit, the four colors and the next setting */
+typedef struct {
+	TCS3414_Frame frame;
+	I2cXfer control;
+	I2cXfer disable;
+	I2cXfer timing;
+	I2cXfer gain;
+	I2cXfer enable;
+	UINT32  outstanding;
+	INT16   status;
+} HdrBatch;
+
+/* Report of the run */
+typedef struct {
+	UINT32 used[HDR_MAX_EXPOSURES];
+	UINT32 saturated[HDR_MAX_EXPOSURES];
+	UINT32 failed;		/* transfer failed, the bracket is dropped */
+	UINT32 notReady;	/* ADC valid bit not set when read */
+} HdrReport;
+
+static HdrBatch hdrBatch;
+
+/************************************************************************/
+/* Parse a bracket "ms:gain,ms:gain,...", e.g. "12:1,100:16"			*/
+/************************************************************************/
+
+INT16 hdr_parse(const char *text, HdrBracket *bracket) {
+	const char *p = text;
+	UINT32 ms, gain;
+	int used;
+	TCS3414_Config *config;
+
+	memset(bracket, 0, sizeof(*bracket));
+
+	while (*p != '\0') {
+		if (bracket->count == HDR_MAX_EXPOSURES
+				|| sscanf(p, "%u:%u%n", &ms, &gain, &used) < 2)
+			return -1;
+		p += used;
+		if (*p == ',')
+			p++;
+
+		config = &bracket->config[bracket->count];
+		switch (ms) {
+		case 12:
+			config->timing = TCS3414_INTEG_12MS;
+			break;
+		case 100:
+			config->timing = TCS3414_INTEG_100MS;
+			break;
+		case 400:
+			config->timing = TCS3414_INTEG_400MS;
+			break;
+		default:
+			return -1;
+		}
+		switch (gain) {
+		case 1:
+			config->gain = TCS3414_GAIN_1X;
+			break;
+		case 4:
+			config->gain = TCS3414_GAIN_4X;
+			break;
+		case 16:
+			config->gain = TCS3414_GAIN_16X;
+			break;
+		case 64:
+			config->gain = TCS3414_GAIN_64X;
+			break;
+		default:
+			return -1;
+		}
+
+		bracket->integUs[bracket->count] = TCS3414_IntegrationUs(config->timing);
+		bracket->factor[bracket->count] = bracket->integUs[bracket->count]
+				/ 1000.0 * TCS3414_GainFactor(config->gain);
+		bracket->saturation[bracket->count] =
+				TCS3414_FullScale(config->timing) * HDR_SATURATION;
+		bracket->count++;
+	}
+	return bracket->count ? 0 : -1;
+}
+
+/************************************************************************
+ * Merge the frames of a bracket. Every unsaturated count is a linear
+ * estimate count / factor with variance (count + read noise) / factor^2
+ * (shot noise), the estimates are averaged with inverse variance
+ * weights. If every frame of a channel saturated, the least sensitive
+ * one gives a lower bound and the channel is flagged.
+ ************************************************************************/
+
+void hdr_merge(const HdrBracket *bracket, UINT16 raw[][4], const bool *valid,
+		HdrSample *sample) {
+	FLOAT64 weight, sumWeight, sum;
+	FLOAT32 factor, leastFactor;
+	UINT32 e, channel, count, bound;
+
+	memset(sample, 0, sizeof(*sample));
+	for (e = 0; e < bracket->count; e++)
+		if (valid[e])
+			sample->exposures++;
+
+	for (channel = 0; channel < 4; channel++) {
+		sumWeight = sum = 0.0;
+		leastFactor = 0.0;
+		bound = 0;
+
+		for (e = 0; e < bracket->count; e++) {
+			if (!valid[e])
+				continue;
+			factor = bracket->factor[e];
+			count = raw[e][channel];
+
+			if (count >= bracket->saturation[e]) {
+				if (leastFactor == 0.0 || factor < leastFactor) {
+					leastFactor = factor;
+					bound = count;
+				}
+				continue;
+			}
+
+			weight = factor * factor / (count + HDR_READ_NOISE);
+			sumWeight += weight;
+			sum += weight * count / factor;
+		}
+
+		if (sumWeight > 0.0) {
+			sample->color[channel] = sum / sumWeight;
+		} else if (leastFactor > 0.0) {
+			sample->color[channel] = bound / leastFactor;
+			sample->saturated |= 1 << channel;
+		}
+	}
+}
+
+/************************************************************************/
+/* Completion of the parts of a batch, called from i2c_async_poll()		*/
+/************************************************************************/
+
+static void hdr_part_done(HdrBatch *batch, INT16 status) {
+	if (status < 0 && batch->status == 0)
+		batch->status = status;
+	batch->outstanding--;
+}
+
+static void hdr_frame_done(TCS3414_Frame *frame, void *arg) {
+	hdr_part_done(arg, frame->status);
+}
+
+static void hdr_xfer_done(I2cXfer *xfer, INT16 status, void *arg) {
+	hdr_part_done(arg, status);
+}
+
+/************************************************************************/
+/* Fill a register write (or a register read if rlen is set)			*/
+/************************************************************************/
+
+static void hdr_prepare_xfer(I2cXfer *xfer, HdrBatch *batch, UINT8 reg,
+		UINT8 value, UINT16 rlen) {
+	xfer->addr = i2c_get_address();
+	xfer->wbuf[0] = TCS3414_BYTE_WISE | reg;
+	xfer->wbuf[1] = value;
+	xfer->wlen = rlen ? 1 : 2;
+	xfer->rlen = rlen;
+	xfer->timeoutUs = I2C_ASYNC_TIMEOUT_US;
+	xfer->retries = I2C_ASYNC_RETRIES;
+	xfer->callback = hdr_xfer_done;
+	xfer->arg = batch;
+}
+
+/************************************************************************
+ * Submit one batch: read the frame (if read) and write the next
+ * setting. The timing register is written with ADC_EN at 0 (datasheet,
+ * control register note 2), setting ADC_EN starts the integration. The
+ * time it was started is in batch->enable.completed after hdr_wait().
+ ************************************************************************/
+
+static INT16 hdr_exchange(HdrBatch *batch, bool read,
+		const TCS3414_Config *next) {
+	I2cXfer *xfers[9];
+	UINT32 count = 0, color;
+
+	batch->status = 0;
+	batch->outstanding = 4;
+
+	if (read) {
+		hdr_prepare_xfer(&batch->control, batch, TCS3414_CONTROL, 0, 1);
+		TCS3414_CxxPrepareReadColors(&batch->frame, I2C_ASYNC_TIMEOUT_US,
+				hdr_frame_done, batch);
+		xfers[count++] = &batch->control;
+		for (color = GREEN; color <= CLEAR; color++)
+			xfers[count++] = &batch->frame.xfer[color];
+		batch->outstanding += 2;
+	}
+	hdr_prepare_xfer(&batch->disable, batch, TCS3414_CONTROL,
+			TCS3414_POWER_ON, 0);
+	hdr_prepare_xfer(&batch->timing, batch, TCS3414_TIMING, next->timing, 0);
+	hdr_prepare_xfer(&batch->gain, batch, TCS3414_GAIN, next->gain, 0);
+	hdr_prepare_xfer(&batch->enable, batch, TCS3414_CONTROL,
+			TCS3414_POWER_ON_ADC_EN, 0);
+	xfers[count++] = &batch->disable;
+	xfers[count++] = &batch->timing;
+	xfers[count++] = &batch->gain;
+	xfers[count++] = &batch->enable;
+
+	if (i2c_async_submit_batch(xfers, count) < 0)
+		return -1;
+
+	/* the caller merges while this is on the bus, see hdr_run() */
+	return 0;
+}
+
+static INT16 hdr_wait(HdrBatch *batch) {
+	/* every transaction completes by its deadline at the latest */
+	while (batch->outstanding) {
+		usleep(HDR_POLL_US);
+		i2c_async_poll();
+	}
+	return batch->status;
+}
+
+/************************************************************************/
+/* Write one merged sample to stdout									*/
+/************************************************************************/
+
+static void hdr_write(CaptureFormat format, UINT64 timeUs,
+		const HdrSample *sample) {
+	HdrRecord record;
+
+	if (format == CAPTURE_BINARY) {
+		record.timeUs = timeUs;
+		memcpy(record.color, sample->color, sizeof(record.color));
+		record.saturated = sample->saturated;
+		fwrite(&record, sizeof(record), 1, stdout);
+		return;
+	}
+
+	printf("%llu,%.3f,%.3f,%.3f,%.3f,%u\n", timeUs, sample->color[GREEN],
+			sample->color[RED], sample->color[BLUE], sample->color[CLEAR],
+			sample->saturated);
+}
+
+/************************************************************************
+ * Run the bracket until the sample or time limit is reached or running
+ * is cleared. Writes one merged sample per bracket to stdout, the
+ * report goes to stderr.
+ ************************************************************************/
+
+INT16 hdr_run(const HdrBracket *bracket, const CaptureOptions *options,
+		volatile sig_atomic_t *running) {
+	UINT16 raw[HDR_MAX_EXPOSURES][4];
+	bool valid[HDR_MAX_EXPOSURES];
+	HdrReport report;
+	HdrSample sample;
+	struct timespec wake;
+	UINT64 start, now, appliedUs, readUs = 0, idealUs = 0;
+	UINT32 current = 0, next, samples = 0, e, channel;
+	bool merge = false;
+	FLOAT64 seconds;
+	INT16 status;
+
+	memset(&report, 0, sizeof(report));
+	memset(valid, 0, sizeof(valid));
+	for (e = 0; e < bracket->count; e++)
+		idealUs += bracket->integUs[e] * (1 + HDR_DISCARD_CYCLES);
+
+	signal(SIGPIPE, SIG_IGN);
+	if (options->format == CAPTURE_CSV)
+		printf("time_us,green,red,blue,clear,saturated\n");
+
+	/* the first setting starts the first integration */
+	if (hdr_exchange(&hdrBatch, false, &bracket->config[0]) < 0
+			|| hdr_wait(&hdrBatch) < 0) {
+		fprintf(stderr, "hdr: could not write the first setting\n");
+		return -1;
+	}
+	appliedUs = hdrBatch.enable.completed;
+	start = i2c_now_us();
+
+	while (*running) {
+		/* sleep until the frame of the current setting is complete, the
+		 * discarded cycles first: whatever the sensor clock, the frame
+		 * then integrated entirely with the current setting */
+		now = appliedUs + bracket->integUs[current] * (1 + HDR_DISCARD_CYCLES)
+				+ HDR_MARGIN_US;
+		wake.tv_sec = now / 1000000;
+		wake.tv_nsec = now % 1000000 * 1000;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+
+		/* read it and start the next one in the same transfer */
+		next = (current + 1) % bracket->count;
+		status = hdr_exchange(&hdrBatch, true, &bracket->config[next]);
+
+		/* the last bracket is merged while the transfer is on the bus */
+		if (merge) {
+			hdr_merge(bracket, raw, valid, &sample);
+			hdr_write(options->format, readUs - start, &sample);
+			memset(valid, 0, sizeof(valid));
+			samples++;
+			merge = false;
+		}
+
+		if (status == 0)
+			status = hdr_wait(&hdrBatch);
+		if (status < 0) {
+			/* the setting is unknown, write it again and drop the bracket */
+			report.failed++;
+			memset(valid, 0, sizeof(valid));
+			next = 0;
+			while (*running && (hdr_exchange(&hdrBatch, false,
+					&bracket->config[next]) < 0 || hdr_wait(&hdrBatch) < 0))
+				usleep(HDR_MARGIN_US);
+		} else if (!(hdrBatch.control.rbuf[0] & TCS3414_ADC_VALID)) {
+			report.notReady++;
+		} else {
+			memcpy(raw[current], hdrBatch.frame.color, sizeof(raw[current]));
+			valid[current] = true;
+			report.used[current]++;
+			for (channel = 0; channel < 4; channel++)
+				if (raw[current][channel] >= bracket->saturation[current]) {
+					report.saturated[current]++;
+					break;
+				}
+		}
+		appliedUs = hdrBatch.enable.completed;
+		readUs = hdrBatch.enable.completed;
+
+		/* a bracket is complete when the first setting comes around */
+		if (next == 0) {
+			for (e = 0; e < bracket->count && !valid[e]; e++)
+				;
+			merge = e < bracket->count;
+		}
+		current = next;
+
+		now = i2c_now_us();
+		if ((options->samples && samples >= options->samples)
+				|| (options->seconds && now - start >= options->seconds * 1e6)
+				|| ferror(stdout))
+			break;
+	}
+
+	if (merge && !(options->samples && samples >= options->samples)) {
+		hdr_merge(bracket, raw, valid, &sample);
+		hdr_write(options->format, readUs - start, &sample);
+		samples++;
+	}
+	fflush(stdout);
+	seconds = (i2c_now_us() - start) / 1e6;
+
+	fprintf(stderr, "hdr: %u samples in %.3f s (%.2f samples/s), bracket "
+			"%.1f ms, integration %.1f ms\n", samples, seconds,
+			seconds > 0 ? samples / seconds : 0.0,
+			samples ? seconds * 1000.0 / samples : 0.0, idealUs / 1000.0);
+	for (e = 0; e < bracket->count; e++)
+		fprintf(stderr, "hdr: %5.1f ms %2ux: %u frames, %u saturated\n",
+				bracket->integUs[e] / 1000.0,
+				TCS3414_GainFactor(bracket->config[e].gain), report.used[e],
+				report.saturated[e]);
+	fprintf(stderr, "hdr: %u transfers failed, %u frames not ready\n",
+			report.failed, report.notReady);
+
+	return ferror(stdout) ? -1 : 0;
+}
@@ -0,0 +1,86 @@
+/*
+ ***************************************************************************
+ * \brief   HDR acquisition
+ *	    	Cycles timing and gain through a short bracket of settings
+ *	    	and merges one frame of every setting into one linear value
+ *	    	per channel, in counts per ms at gain 1x. Saturated frames
+ *	    	do not count, the others are weighted by their noise.
+ * \file    hdr.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 first cycle after a setting change discarded
+ ***************************************************************************
+ */
+
+#ifndef HDR_H
+#define HDR_H
+
+#include <signal.h>
+
+#include "TCS3414.h"
+#include "capture.h"
+
+/* Settings of one bracket */
+#define HDR_MAX_EXPOSURES	4
+
+/* Default bracket: 12 ms at every gain, a range of 64 in about 100 ms */
+#define HDR_DEFAULT_BRACKET	"12:1,12:4,12:16,12:64"
+
+/* A count above this part of the full scale is saturated */
+#define HDR_SATURATION		0.95
+
+/* Noise of a count that does not depend on the light (quantization) */
+#define HDR_READ_NOISE		1.0
+
+/* The frame is read this long after the integration should be done */
+#define HDR_MARGIN_US		500
+
+/* Integration cycles after a setting change that are not read. The
+ * datasheet does not say whether the frame of the running cycle has
+ * the old or the new setting, nor how exact the internal clock is; the
+ * second cycle after the change is certainly the new one. */
+#define HDR_DISCARD_CYCLES	1
+
+/* Poll interval while a transfer is on the bus */
+#define HDR_POLL_US		100
+
+typedef struct {
+	UINT32  count;
+	TCS3414_Config config[HDR_MAX_EXPOSURES];
+	UINT32  integUs[HDR_MAX_EXPOSURES];
+	FLOAT32 factor[HDR_MAX_EXPOSURES];	/* counts per (count per ms at 1x) */
+	UINT16  saturation[HDR_MAX_EXPOSURES];	/* first saturated count */
+} HdrBracket;
+
+/* Merged sample, a set bit in saturated is a channel beyond the range */
+typedef struct {
+	FLOAT32 color[4];	/* indexed by Color */
+	UINT8   saturated;	/* bit 1 << Color */
+	UINT8   exposures;	/* valid frames that went into the merge */
+} HdrSample;
+
+/* Binary record, as CaptureRecord with linear values */
+typedef struct __attribute__((packed)) {
+	UINT64  timeUs;
+	FLOAT32 color[4];
+	UINT8   saturated;
+} HdrRecord;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 hdr_parse(const char *text, HdrBracket *bracket);
+extern void  hdr_merge(const HdrBracket *bracket, UINT16 raw[][4],
+		const bool *valid, HdrSample *sample);
+extern INT16 hdr_run(const HdrBracket *bracket, const CaptureOptions *options,
+		volatile sig_atomic_t *running);
+
+/* #ifndef HDR_H */
+#endif
@@ -0,0 +1,748 @@
+/*
+ ***************************************************************************
+ * \brief   Embedded HTTP server
+ *	    	The acquisition stores the latest sample under a mutex and
+ *	    	wakes the server through an eventfd, at most once until the
+ *	    	server took it. The server serializes the sample into a
+ *	    	reference counted event and hands it to every stream: an
+ *	    	idle stream sends it right away, a busy one keeps it as its
+ *	    	next event and drops the one it kept before. So a slow
+ *	    	client holds at most two events and never slows down the
+ *	    	others or the acquisition.
+ *	    	All sockets are non-blocking, epoll is level triggered and
+ *	    	EPOLLOUT is only watched while a client has data left.
+ *	    	Out of fds the listen socket is not watched until a client
+ *	    	closes, otherwise the level triggered accept would spin.
+ * \file    http.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 listen socket not watched while out of fds
+ ***************************************************************************
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "http.h"
+#include "batch.h"
+
+#define HTTP_STR(x)	HTTP_STR2(x)
+#define HTTP_STR2(x)	#x
+
+/* A serialized update, shared by all streams that send it */
+typedef struct {
+	UINT32 refs;
+	UINT32 len;
+	char   data[HTTP_EVENT_SIZE];
+} HttpEvent;
+
+typedef struct HttpClient HttpClient;
+
+struct HttpClient {
+	int         fd;
+	bool        stream;		/* /events, stays open */
+	bool        pollOut;		/* EPOLLOUT is watched */
+	char        request[HTTP_REQUEST_SIZE];
+	UINT32      requestLen;
+	const char *out;		/* response or stream header being sent */
+	UINT32      outLen;
+	UINT32      outSent;
+	char       *response;		/* owned, NULL if out is static */
+	HttpEvent  *event;		/* update being sent */
+	UINT32      eventSent;
+	HttpEvent  *pending;		/* newest update, sent after event */
+	HttpClient *prev;
+	HttpClient *next;
+};
+
+/*
+ ***************************************************************************
+ * Vars
+ ***************************************************************************
+ */
+
+/* shared with the acquisition */
+static pthread_mutex_t httpLock = PTHREAD_MUTEX_INITIALIZER;
+static HttpSample httpSample;
+static HttpStats httpStats;
+static bool httpWakePending;
+
+static bool httpRunning;
+static bool httpStarted;
+static bool httpStop;
+static pthread_t httpThread;
+static int httpListen = -1;
+static int httpWake = -1;
+static int httpEpoll = -1;
+
+/* epoll tags of the two fds that are not clients */
+static char httpListenTag;
+static char httpWakeTag;
+
+/* server thread only: accept failed with EMFILE/ENFILE */
+static bool httpListenPaused;
+
+/* server thread only */
+static HttpClient *httpClients;
+static UINT32 httpClientCount;
+static HttpEvent *httpCurrent;
+static UINT64 httpSerialized;		/* count of the sample in httpCurrent */
+static HttpServerStats httpServerStats;
+
+/* never freed, the reference of the initializer is never dropped */
+static HttpEvent httpPing = { 1, sizeof(": ping\n\n") - 1, ": ping\n\n" };
+
+static const char *const httpColorName[4] = { "green", "red", "blue", "clear" };
+
+static const char httpStreamHeader[] =
+		"HTTP/1.1 200 OK\r\n"
+		"Content-Type: text/event-stream\r\n"
+		"Cache-Control: no-cache\r\n"
+		"Access-Control-Allow-Origin: *\r\n"
+		"Connection: keep-alive\r\n"
+		"\r\n"
+		"retry: 1000\n\n";
+
+/* live color, normalized like the console (see batch.h) */
+static const char httpPage[] =
+		"<!DOCTYPE html>\n"
+		"<html><head><meta charset=\"utf-8\"><title>Farbsensor</title></head>\n"
+		"<body style=\"font-family: sans-serif\">\n"
+		"<h1>Color sensor TCS3414</h1>\n"
+		"<div id=\"color\" style=\"width: 240px; height: 120px; border: 1px solid black\"></div>\n"
+		"<pre id=\"sample\">waiting for the sensor</pre>\n"
+		"<p><a href=\"/snapshot\">snapshot</a></p>\n"
+		"<script>\n"
+		"new EventSource(\"/events\").onmessage = function (e) {\n"
+		"	var s = JSON.parse(e.data);\n"
+		"	var c = [s.red * " HTTP_STR(BATCH_NORM_RED) ", s.green * "
+				HTTP_STR(BATCH_NORM_GREEN) ", s.blue * " HTTP_STR(BATCH_NORM_BLUE) "];\n"
+		"	var max = Math.max(c[0], c[1], c[2], 1);\n"
+		"	document.getElementById(\"color\").style.background = \"rgb(\" + c.map(\n"
+		"			function (v) { return Math.round(255 * v / max); }).join() + \")\";\n"
+		"	document.getElementById(\"sample\").textContent = JSON.stringify(s, null, 1);\n"
+		"};\n"
+		"</script>\n"
+		"</body></html>\n";
+
+/************************************************************************/
+/* Serialization														*/
+/************************************************************************/
+
+static int http_format_sample(char *buf, size_t size, const HttpSample *sample) {
+	return snprintf(buf, size, "{\"number\":%llu,\"time_us\":%llu,"
+			"\"published_us\":%llu,\"green\":%u,\"red\":%u,\"blue\":%u,"
+			"\"clear\":%u}", sample->count - 1, sample->timeUs,
+			sample->publishedUs, sample->color[GREEN], sample->color[RED],
+			sample->color[BLUE], sample->color[CLEAR]);
+}
+
+static UINT32 http_format_event(char *buf, size_t size, const HttpSample *sample) {
+	int len;
+
+	len = snprintf(buf, size, "id: %llu\ndata: ", sample->count - 1);
+	len += http_format_sample(buf + len, size - len, sample);
+	len += snprintf(buf + len, size - len, "\n\n");
+	return len;
+}
+
+/* HTTP_SNAPSHOT_SIZE holds the longest snapshot */
+static void http_format_snapshot(char *buf, size_t size) {
+	HttpSample sample;
+	HttpStats stats;
+	const HttpChannelStats *channel;
+	int len, c;
+
+	pthread_mutex_lock(&httpLock);
+	sample = httpSample;
+	stats = httpStats;
+	pthread_mutex_unlock(&httpLock);
+
+	len = snprintf(buf, size, "{\"sample\":");
+	if (sample.count == 0)
+		len += snprintf(buf + len, size - len, "null");
+	else
+		len += http_format_sample(buf + len, size - len, &sample);
+
+	len += snprintf(buf + len, size - len, ",\"stats\":{\"window_s\":%u",
+			stats.windowSeconds);
+	for (c = 0; c < 4; c++) {
+		channel = &stats.channel[c];
+		len += snprintf(buf + len, size - len, ",\"%s\":{\"samples\":%llu,"
+				"\"mean\":%.1f,\"stddev\":%.2f,\"min\":%u,\"p50\":%u,"
+				"\"p95\":%u,\"max\":%u}", httpColorName[c], channel->count,
+				channel->mean, channel->stddev, channel->min, channel->p50,
+				channel->p95, channel->max);
+	}
+
+	snprintf(buf + len, size - len, "},\"server\":{\"streams\":%u,"
+			"\"updates\":%llu,\"skipped\":%llu,\"coalesced\":%llu}}\n",
+			httpServerStats.streams, httpServerStats.updates,
+			httpServerStats.skipped, httpServerStats.coalesced);
+}
+
+/************************************************************************/
+/* Shared events														*/
+/************************************************************************/
+
+static HttpEvent *http_event_get(HttpEvent *event) {
+	event->refs++;
+	return event;
+}
+
+static void http_event_put(HttpEvent *event) {
+	if (event != NULL && --event->refs == 0)
+		free(event);
+}
+
+/************************************************************************/
+/* Connections															*/
+/************************************************************************/
+
+static void http_listen_watch(bool on) {
+	struct epoll_event ev;
+
+	if (httpListenPaused != on)
+		return;
+
+	ev.events = on ? EPOLLIN : 0;
+	ev.data.ptr = &httpListenTag;
+	if (epoll_ctl(httpEpoll, EPOLL_CTL_MOD, httpListen, &ev) < 0) {
+		perror("httpListenWatch");
+		return;
+	}
+	httpListenPaused = !on;
+}
+
+static void http_close(HttpClient *client) {
+	close(client->fd);
+
+	/* the freed fd lets the waiting connections in */
+	http_listen_watch(true);
+
+	if (client->prev != NULL)
+		client->prev->next = client->next;
+	else
+		httpClients = client->next;
+	if (client->next != NULL)
+		client->next->prev = client->prev;
+	httpClientCount--;
+	if (client->stream)
+		httpServerStats.streams--;
+
+	http_event_put(client->event);
+	http_event_put(client->pending);
+	free(client->response);
+	free(client);
+}
+
+static INT16 http_poll_out(HttpClient *client, bool on) {
+	struct epoll_event ev;
+
+	if (client->pollOut == on)
+		return 0;
+
+	ev.events = EPOLLIN | (on ? EPOLLOUT : 0);
+	ev.data.ptr = client;
+	if (epoll_ctl(httpEpoll, EPOLL_CTL_MOD, client->fd, &ev) < 0)
+		return -1;
+	client->pollOut = on;
+	return 0;
+}
+
+/************************************************************************/
+/* Send as much as the socket takes: response, then the events. Returns	*/
+/* -1 if the client is done (response sent) or broken.					*/
+/************************************************************************/
+
+static INT16 http_send(HttpClient *client) {
+	ssize_t sent;
+
+	for (;;) {
+		if (client->out != NULL) {
+			sent = send(client->fd, client->out + client->outSent,
+					client->outLen - client->outSent, MSG_NOSIGNAL);
+			if (sent < 0)
+				break;
+			httpServerStats.bytes += sent;
+			client->outSent += sent;
+			if (client->outSent < client->outLen)
+				continue;
+
+			free(client->response);
+			client->response = NULL;
+			client->out = NULL;
+			if (!client->stream)
+				return -1;
+		} else if (client->event != NULL) {
+			sent = send(client->fd, client->event->data + client->eventSent,
+					client->event->len - client->eventSent, MSG_NOSIGNAL);
+			if (sent < 0)
+				break;
+			httpServerStats.bytes += sent;
+			client->eventSent += sent;
+			if (client->eventSent < client->event->len)
+				continue;
+
+			httpServerStats.events++;
+			http_event_put(client->event);
+			client->event = NULL;
+		} else if (client->pending != NULL) {
+			client->event = client->pending;
+			client->pending = NULL;
+			client->eventSent = 0;
+		} else
+			return http_poll_out(client, false);
+	}
+
+	/* socket full, go on when it is writable again */
+	if (errno == EAGAIN || errno == EWOULDBLOCK)
+		return http_poll_out(client, true);
+	return -1;
+}
+
+static INT16 http_reply(HttpClient *client, const char *status,
+		const char *type, const char *body) {
+	size_t size = strlen(body) + 256;
+
+	client->response = malloc(size);
+	if (client->response == NULL)
+		return -1;
+	client->outLen = snprintf(client->response, size, "HTTP/1.1 %s\r\n"
+			"Content-Type: %s\r\n"
+			"Content-Length: %zu\r\n"
+			"Cache-Control: no-cache\r\n"
+			"Access-Control-Allow-Origin: *\r\n"
+			"Connection: close\r\n"
+			"\r\n"
+			"%s", status, type, strlen(body), body);
+	client->out = client->response;
+	client->outSent = 0;
+	return http_send(client);
+}
+
+/* The stream starts with the latest update, if there is one */
+static INT16 http_stream(HttpClient *client) {
+	client->stream = true;
+	client->out = httpStreamHeader;
+	client->outLen = sizeof(httpStreamHeader) - 1;
+	client->outSent = 0;
+	if (httpCurrent != NULL)
+		client->pending = http_event_get(httpCurrent);
+
+	httpServerStats.streams++;
+	if (httpServerStats.streams > httpServerStats.maxStreams)
+		httpServerStats.maxStreams = httpServerStats.streams;
+	return http_send(client);
+}
+
+static INT16 http_respond(HttpClient *client) {
+	char method[8], path[128], *query;
+	char body[HTTP_SNAPSHOT_SIZE];
+
+	httpServerStats.requests++;
+	if (sscanf(client->request, "%7s %127s", method, path) != 2)
+		return http_reply(client, "400 Bad Request", "text/plain", "bad request\n");
+	query = strchr(path, '?');
+	if (query != NULL)
+		*query = '\0';
+
+	if (strcmp(method, "GET") != 0)
+		return http_reply(client, "405 Method Not Allowed", "text/plain",
+				"only GET\n");
+	if (strcmp(path, "/") == 0)
+		return http_reply(client, "200 OK", "text/html; charset=utf-8", httpPage);
+	if (strcmp(path, "/snapshot") == 0) {
+		http_format_snapshot(body, sizeof(body));
+		return http_reply(client, "200 OK", "application/json", body);
+	}
+	if (strcmp(path, "/events") == 0)
+		return http_stream(client);
+	return http_reply(client, "404 Not Found", "text/plain", "not found\n");
+}
+
+/************************************************************************/
+/* Read the request; once the response is under way the input is		*/
+/* discarded, only the end of the connection matters					*/
+/************************************************************************/
+
+static INT16 http_receive(HttpClient *client) {
+	char discard[256];
+	ssize_t len;
+
+	for (;;) {
+		if (client->stream || client->out != NULL)
+			len = recv(client->fd, discard, sizeof(discard), 0);
+		else
+			len = recv(client->fd, client->request + client->requestLen,
+					sizeof(client->request) - 1 - client->requestLen, 0);
+		if (len == 0)
+			return -1;
+		if (len < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+		if (client->stream || client->out != NULL)
+			continue;
+
+		client->requestLen += len;
+		client->request[client->requestLen] = '\0';
+		if (strstr(client->request, "\r\n\r\n") != NULL
+				|| strstr(client->request, "\n\n") != NULL)
+			return http_respond(client);
+		if (client->requestLen == sizeof(client->request) - 1)
+			return http_reply(client, "431 Request Header Fields Too Large",
+					"text/plain", "request too large\n");
+	}
+}
+
+static void http_accept(void) {
+	struct epoll_event ev;
+	HttpClient *client;
+	int fd, one = 1;
+
+	for (;;) {
+		fd = accept4(httpListen, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			/* out of fds: the connection waits in the backlog and
+			 * the listen socket is not watched until an fd is free */
+			if (errno == EMFILE || errno == ENFILE) {
+				httpServerStats.rejected++;
+				http_listen_watch(false);
+			} else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				perror("httpAccept");
+			return;
+		}
+
+		client = httpClientCount < HTTP_MAX_CLIENTS
+				? calloc(1, sizeof(*client)) : NULL;
+		if (client == NULL) {
+			close(fd);
+			httpServerStats.rejected++;
+			continue;
+		}
+
+		/* the updates are small and should go out right away */
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+		client->fd = fd;
+		ev.events = EPOLLIN;
+		ev.data.ptr = client;
+		if (epoll_ctl(httpEpoll, EPOLL_CTL_ADD, fd, &ev) < 0) {
+			perror("httpEpollAdd");
+			close(fd);
+			free(client);
+			continue;
+		}
+
+		client->next = httpClients;
+		if (httpClients != NULL)
+			httpClients->prev = client;
+		httpClients = client;
+		httpClientCount++;
+		httpServerStats.connections++;
+	}
+}
+
+/************************************************************************/
+/* Hand an event to all streams											*/
+/************************************************************************/
+
+static void http_fanout(HttpEvent *event) {
+	HttpClient *client, *next;
+
+	for (client = httpClients; client != NULL; client = next) {
+		next = client->next;
+		if (!client->stream)
+			continue;
+
+		if (client->pending != NULL) {
+			http_event_put(client->pending);
+			httpServerStats.coalesced++;
+		}
+		client->pending = http_event_get(event);
+
+		/* a stream waiting for EPOLLOUT goes on when it gets it */
+		if (!client->pollOut && http_send(client) < 0)
+			http_close(client);
+	}
+}
+
+/* Serialize the latest sample once and send it to all streams */
+static void http_update(void) {
+	HttpSample sample;
+	HttpEvent *event;
+	UINT64 value, start, serialized;
+
+	if (read(httpWake, &value, sizeof(value)) < 0 && errno != EAGAIN)
+		perror("httpWakeRead");
+
+	pthread_mutex_lock(&httpLock);
+	sample = httpSample;
+	httpWakePending = false;
+	pthread_mutex_unlock(&httpLock);
+
+	if (sample.count == httpSerialized)
+		return;
+
+	start = i2c_now_us();
+	event = malloc(sizeof(*event));
+	if (event == NULL)
+		return;
+	event->refs = 1;
+	event->len = http_format_event(event->data, sizeof(event->data), &sample);
+	serialized = i2c_now_us();
+
+	http_event_put(httpCurrent);
+	httpCurrent = event;
+	http_fanout(event);
+
+	httpServerStats.skipped += sample.count - httpSerialized - 1;
+	httpSerialized = sample.count;
+	httpServerStats.updates++;
+	httpServerStats.serializeUs += serialized - start;
+	httpServerStats.fanoutUs += i2c_now_us() - serialized;
+}
+
+/************************************************************************/
+/* Server thread														*/
+/************************************************************************/
+
+static void *http_thread(void *arg) {
+	struct epoll_event events[HTTP_EPOLL_EVENTS];
+	bool update;
+	int n, i;
+
+	while (!__atomic_load_n(&httpStop, __ATOMIC_ACQUIRE)) {
+		n = epoll_wait(httpEpoll, events, HTTP_EPOLL_EVENTS, HTTP_KEEPALIVE_MS);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("httpEpollWait");
+			break;
+		}
+
+		/* idle streams get a comment so proxies keep them open, and
+		 * fds freed outside the server are taken up again */
+		if (n == 0) {
+			http_fanout(&httpPing);
+			http_listen_watch(true);
+			continue;
+		}
+
+		/* a closed client only appears in its own event */
+		update = false;
+		for (i = 0; i < n; i++) {
+			if (events[i].data.ptr == &httpListenTag)
+				http_accept();
+			else if (events[i].data.ptr == &httpWakeTag)
+				update = true;
+			else if ((events[i].events & (EPOLLERR | EPOLLHUP))
+					|| ((events[i].events & EPOLLIN)
+							&& http_receive(events[i].data.ptr) < 0)
+					|| ((events[i].events & EPOLLOUT)
+							&& http_send(events[i].data.ptr) < 0))
+				http_close(events[i].data.ptr);
+		}
+		if (update)
+			http_update();
+	}
+	return NULL;
+}
+
+/************************************************************************/
+/* Sockets with many connections need more than the default 1024 fds	*/
+/************************************************************************/
+
+INT16 http_raise_fd_limit(void) {
+	struct rlimit limit;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) < 0
+			|| (limit.rlim_cur = limit.rlim_max,
+					setrlimit(RLIMIT_NOFILE, &limit) < 0)) {
+		perror("httpFdLimit");
+		return -1;
+	}
+	return 0;
+}
+
+static void http_close_fds(void) {
+	if (httpEpoll >= 0)
+		close(httpEpoll);
+	if (httpWake >= 0)
+		close(httpWake);
+	if (httpListen >= 0)
+		close(httpListen);
+	httpEpoll = httpWake = httpListen = -1;
+}
+
+/************************************************************************
+ * Listen on all interfaces and start the server thread. The thread
+ * inherits the scheduling of the caller, so start it before the
+ * real-time mode.
+ ************************************************************************/
+
+INT16 http_start(UINT16 port) {
+	struct sockaddr_in addr;
+	struct epoll_event ev;
+	int one = 1, error;
+
+	http_raise_fd_limit();
+
+	httpListen = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (httpListen < 0) {
+		perror("httpSocket");
+		return -1;
+	}
+	setsockopt(httpListen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if (bind(httpListen, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		perror("httpBind");
+		goto fail;
+	}
+	if (listen(httpListen, SOMAXCONN) < 0) {
+		perror("httpListen");
+		goto fail;
+	}
+
+	httpWake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	httpEpoll = epoll_create1(EPOLL_CLOEXEC);
+	if (httpWake < 0 || httpEpoll < 0) {
+		perror("httpEpoll");
+		goto fail;
+	}
+
+	ev.events = EPOLLIN;
+	ev.data.ptr = &httpListenTag;
+	if (epoll_ctl(httpEpoll, EPOLL_CTL_ADD, httpListen, &ev) < 0) {
+		perror("httpEpollAdd");
+		goto fail;
+	}
+	ev.data.ptr = &httpWakeTag;
+	if (epoll_ctl(httpEpoll, EPOLL_CTL_ADD, httpWake, &ev) < 0) {
+		perror("httpEpollAdd");
+		goto fail;
+	}
+
+	httpStop = false;
+	httpListenPaused = false;
+	error = pthread_create(&httpThread, NULL, http_thread, NULL);
+	if (error != 0) {
+		errno = error;
+		perror("httpThread");
+		goto fail;
+	}
+	httpRunning = true;
+	httpStarted = true;
+	return 0;
+
+fail:
+	http_close_fds();
+	return -1;
+}
+
+/************************************************************************/
+/* Hand a sample to the server, does nothing if it does not run. Never	*/
+/* waits for a client; samples that come before the server took the		*/
+/* last one replace it.													*/
+/************************************************************************/
+
+void http_publish(UINT64 timeUs, const UINT16 *color) {
+	UINT64 one = 1;
+	bool wake;
+
+	if (!httpRunning)
+		return;
+
+	pthread_mutex_lock(&httpLock);
+	httpSample.count++;
+	httpSample.timeUs = timeUs;
+	httpSample.publishedUs = i2c_now_us();
+	memcpy(httpSample.color, color, sizeof(httpSample.color));
+	wake = !httpWakePending;
+	httpWakePending = true;
+	pthread_mutex_unlock(&httpLock);
+
+	if (wake && write(httpWake, &one, sizeof(one)) < 0)
+		perror("httpWake");
+}
+
+/* Statistics of the snapshot, the quantiles are computed here */
+void http_publish_stats(const StatsSet *window, UINT32 windowSeconds) {
+	HttpStats stats;
+	const StatsChannel *channel;
+	int c;
+
+	if (!httpRunning)
+		return;
+
+	stats.windowSeconds = windowSeconds;
+	for (c = 0; c < 4; c++) {
+		channel = &window->channel[c];
+		stats.channel[c].count = channel->moments.count;
+		stats.channel[c].mean = channel->moments.mean;
+		stats.channel[c].stddev = sqrt(stats_variance(channel));
+		stats.channel[c].min = channel->moments.count ? channel->moments.min : 0;
+		stats.channel[c].p50 = stats_quantile(channel, 0.5);
+		stats.channel[c].p95 = stats_quantile(channel, 0.95);
+		stats.channel[c].max = channel->moments.max;
+	}
+
+	pthread_mutex_lock(&httpLock);
+	httpStats = stats;
+	pthread_mutex_unlock(&httpLock);
+}
+
+void http_stop(void) {
+	UINT64 one = 1;
+
+	if (!httpRunning)
+		return;
+	httpRunning = false;
+
+	__atomic_store_n(&httpStop, true, __ATOMIC_RELEASE);
+	if (write(httpWake, &one, sizeof(one)) < 0)
+		perror("httpWake");
+	pthread_join(httpThread, NULL);
+
+	while (httpClients != NULL)
+		http_close(httpClients);
+	http_event_put(httpCurrent);
+	httpCurrent = NULL;
+	http_close_fds();
+}
+
+void http_print_stats(FILE *out) {
+	const HttpServerStats *s = &httpServerStats;
+
+	if (!httpStarted)
+		return;
+
+	fprintf(out, "http: %llu connections (%llu rejected), %llu requests, "
+			"%u streams at most\n", s->connections, s->rejected, s->requests,
+			s->maxStreams);
+	fprintf(out, "http: %llu updates (%llu samples skipped), serialized in "
+			"%.2f us, handed to the streams in %.1f us\n", s->updates, s->skipped,
+			s->updates ? (FLOAT64) s->serializeUs / s->updates : 0.0,
+			s->updates ? (FLOAT64) s->fanoutUs / s->updates : 0.0);
+	fprintf(out, "http: %llu events sent, %llu coalesced, %llu bytes\n",
+			s->events, s->coalesced, s->bytes);
+}
@@ -0,0 +1,105 @@
+/*
+ ***************************************************************************
+ * \brief   Embedded HTTP server
+ *	    	One thread serves all connections with epoll:
+ *	    	  /          a page that shows the live color
+ *	    	  /snapshot  JSON of the latest sample and statistics
+ *	    	  /events    Server-Sent Events stream of the samples
+ *	    	The acquisition hands its samples over with http_publish(),
+ *	    	which never blocks on a client. Every update is serialized
+ *	    	once and the same buffer is sent to all streams. A stream
+ *	    	that is still busy with an older update gets only the newest
+ *	    	one when it is ready again (coalescing).
+ * \file    http.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 rejected counts running out of fds
+ ***************************************************************************
+ */
+
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "TCS3414.h"
+#include "stats.h"
+
+/* Port of the server (-W) and of the load generator (-G) */
+#define HTTP_DEFAULT_PORT	8080
+
+/* Connections beyond this are closed right after the accept */
+#define HTTP_MAX_CLIENTS	16384
+
+/* A request must fit, the server only reads the request line */
+#define HTTP_REQUEST_SIZE	1024
+
+/* Size of a serialized update and of a snapshot */
+#define HTTP_EVENT_SIZE		256
+#define HTTP_SNAPSHOT_SIZE	2048
+
+/* A stream gets a comment after this long without updates */
+#define HTTP_KEEPALIVE_MS	15000
+
+/* epoll events handled per wakeup */
+#define HTTP_EPOLL_EVENTS	256
+
+/* Latest sample and statistics as the server sends them */
+typedef struct {
+	UINT64 count;		/* samples published so far */
+	UINT64 timeUs;		/* of the sample, CLOCK_MONOTONIC */
+	UINT64 publishedUs;	/* when http_publish() got it */
+	UINT16 color[4];	/* indexed by Color */
+} HttpSample;
+
+typedef struct {
+	UINT64  count;
+	FLOAT64 mean;
+	FLOAT64 stddev;
+	UINT16  min;
+	UINT16  p50;
+	UINT16  p95;
+	UINT16  max;
+} HttpChannelStats;
+
+typedef struct {
+	UINT32 windowSeconds;
+	HttpChannelStats channel[4];
+} HttpStats;
+
+/* Server side counters */
+typedef struct {
+	UINT64 connections;	/* accepted */
+	UINT64 rejected;	/* above HTTP_MAX_CLIENTS or out of fds */
+	UINT64 requests;
+	UINT32 streams;		/* open now */
+	UINT32 maxStreams;
+	UINT64 updates;		/* serialized */
+	UINT64 skipped;		/* samples replaced before the server took them */
+	UINT64 events;		/* updates sent completely to a stream */
+	UINT64 coalesced;	/* updates a busy stream never got */
+	UINT64 bytes;
+	UINT64 serializeUs;
+	UINT64 fanoutUs;	/* handing the updates to all streams */
+} HttpServerStats;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 http_start(UINT16 port);
+extern void  http_publish(UINT64 timeUs, const UINT16 *color);
+extern void  http_publish_stats(const StatsSet *window, UINT32 windowSeconds);
+extern void  http_stop(void);
+extern void  http_print_stats(FILE *out);
+extern INT16 http_raise_fd_limit(void);
+
+/* #ifndef HTTP_H */
+#endif
@@ -0,0 +1,356 @@
+/*
+ ***************************************************************************
+ * \brief   Load generator for the embedded HTTP server
+ *	    	All streams are served by one epoll loop, like on the server
+ *	    	side. The latency of an update is the time from the
+ *	    	completion of the sample read to the arrival of the whole
+ *	    	update, so it includes the time until the acquisition
+ *	    	handed the sample to http_publish(). The latency from
+ *	    	http_publish() alone is reported as well.
+ * \file    http_load.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 latency from the sample time, from publish as well
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "http_load.h"
+
+typedef struct {
+	int    fd;
+	bool   header;		/* the response header is through */
+	bool   seen;		/* got an update in this step */
+	UINT64 last;		/* number of the last update */
+	UINT32 len;
+	char   buf[HTTP_LOAD_BUFFER];
+} HttpLoadClient;
+
+/* Results of one step */
+typedef struct {
+	UINT64  events;
+	UINT64  missed;		/* updates a stream did not get */
+	UINT64  first;		/* lowest and highest update number seen */
+	UINT64  last;
+	UINT32 *latency;	/* us since the sample was read, one per event */
+	UINT32 *publish;	/* us since http_publish(), one per event */
+	UINT64  count;
+	UINT64  size;
+} HttpLoadStep;
+
+static const char httpLoadStream[] =
+		"GET /events HTTP/1.1\r\nHost: localhost\r\n"
+		"Accept: text/event-stream\r\n\r\n";
+static const char httpLoadSnapshot[] =
+		"GET /snapshot HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+/************************************************************************/
+/* Blocking connect to localhost and send the request					*/
+/************************************************************************/
+
+static int http_load_connect(UINT16 port, const char *request) {
+	struct sockaddr_in addr;
+	size_t len = strlen(request);
+	int fd;
+
+	fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		perror("httpLoadSocket");
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		perror("httpLoadConnect");
+		close(fd);
+		return -1;
+	}
+	if (send(fd, request, len, MSG_NOSIGNAL) != (ssize_t) len) {
+		perror("httpLoadSend");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/************************************************************************/
+/* One update arrived													*/
+/************************************************************************/
+
+static void http_load_event(HttpLoadClient *client, HttpLoadStep *step,
+		UINT64 number, UINT64 timeUs, UINT64 publishedUs, UINT64 nowUs) {
+	UINT32 *latency, *publish;
+
+	if (client->seen && number > client->last + 1)
+		step->missed += number - client->last - 1;
+	client->seen = true;
+	client->last = number;
+
+	if (step->events == 0 || number < step->first)
+		step->first = number;
+	if (step->events == 0 || number > step->last)
+		step->last = number;
+	step->events++;
+
+	if (step->count == step->size) {
+		step->size = step->size ? 2 * step->size : 65536;
+		latency = realloc(step->latency, step->size * sizeof(*latency));
+		if (latency != NULL)
+			step->latency = latency;
+		publish = realloc(step->publish, step->size * sizeof(*publish));
+		if (publish != NULL)
+			step->publish = publish;
+		if (latency == NULL || publish == NULL) {
+			step->size = step->count;
+			return;
+		}
+	}
+	step->latency[step->count] = nowUs > timeUs ? nowUs - timeUs : 0;
+	step->publish[step->count] = nowUs > publishedUs ? nowUs - publishedUs : 0;
+	step->count++;
+}
+
+/************************************************************************/
+/* Read what a stream got, -1 if the server closed it					*/
+/************************************************************************/
+
+static INT16 http_load_receive(HttpLoadClient *client, HttpLoadStep *step) {
+	char *start, *end, *number, *sampled, *published;
+	ssize_t len;
+	UINT64 now;
+
+	for (;;) {
+		len = recv(client->fd, client->buf + client->len,
+				sizeof(client->buf) - 1 - client->len, 0);
+		if (len == 0)
+			return -1;
+		if (len < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+
+		now = i2c_now_us();
+		client->len += len;
+		client->buf[client->len] = '\0';
+
+		start = client->buf;
+		if (!client->header) {
+			end = strstr(start, "\r\n\r\n");
+			if (end == NULL) {
+				if (client->len == sizeof(client->buf) - 1)
+					return -1;
+				continue;
+			}
+			if (strncmp(start, "HTTP/1.1 200", 12) != 0)
+				return -1;
+			client->header = true;
+			start = end + 4;
+		}
+
+		/* events end with an empty line, the retry field has no data */
+		while ((end = strstr(start, "\n\n")) != NULL) {
+			*end = '\0';
+			number = strstr(start, "\"number\":");
+			sampled = strstr(start, "\"time_us\":");
+			published = strstr(start, "\"published_us\":");
+			if (step != NULL && number != NULL && sampled != NULL
+					&& published != NULL)
+				http_load_event(client, step, strtoull(number + 9, NULL, 10),
+						strtoull(sampled + 10, NULL, 10),
+						strtoull(published + 15, NULL, 10), now);
+			start = end + 2;
+		}
+
+		client->len -= start - client->buf;
+		memmove(client->buf, start, client->len);
+		if (client->len == sizeof(client->buf) - 1)
+			client->len = 0;
+	}
+}
+
+/************************************************************************/
+/* Serve all streams for some time, events only count if step is set	*/
+/************************************************************************/
+
+static void http_load_drain(int epfd, UINT64 us, HttpLoadStep *step) {
+	struct epoll_event events[HTTP_EPOLL_EVENTS];
+	HttpLoadClient *client;
+	UINT64 now, end;
+	int n, i;
+
+	now = i2c_now_us();
+	end = now + us;
+	while (now < end) {
+		n = epoll_wait(epfd, events, HTTP_EPOLL_EVENTS, (end - now + 999) / 1000);
+		for (i = 0; i < n; i++) {
+			client = events[i].data.ptr;
+			if (http_load_receive(client, step) < 0) {
+				close(client->fd);
+				client->fd = -1;
+			}
+		}
+		now = i2c_now_us();
+	}
+}
+
+/************************************************************************/
+/* Time a snapshot request, 0 if it failed								*/
+/************************************************************************/
+
+static UINT64 http_load_snapshot(UINT16 port) {
+	char buf[HTTP_SNAPSHOT_SIZE + 512];
+	UINT64 start;
+	UINT32 len = 0;
+	ssize_t n;
+	int fd;
+
+	start = i2c_now_us();
+	fd = http_load_connect(port, httpLoadSnapshot);
+	if (fd < 0)
+		return 0;
+	while (len < sizeof(buf) - 1
+			&& (n = recv(fd, buf + len, sizeof(buf) - 1 - len, 0)) > 0)
+		len += n;
+	close(fd);
+	buf[len] = '\0';
+	if (strncmp(buf, "HTTP/1.1 200", 12) != 0 || strstr(buf, "\"sample\"") == NULL)
+		return 0;
+	return i2c_now_us() - start;
+}
+
+static int http_load_compare(const void *a, const void *b) {
+	UINT32 x = *(const UINT32 *) a, y = *(const UINT32 *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* p50, p99 and max in ms of count latencies in us, sorts them */
+static void http_load_percentiles(UINT32 *us, UINT64 count, FLOAT64 *ms) {
+	ms[0] = ms[1] = ms[2] = 0.0;
+	if (count == 0)
+		return;
+
+	qsort(us, count, sizeof(*us), http_load_compare);
+	ms[0] = us[count / 2] / 1000.0;
+	ms[1] = us[count * 99 / 100] / 1000.0;
+	ms[2] = us[count - 1] / 1000.0;
+}
+
+/************************************************************************
+ * Open 1, 10, 100 ... maxClients streams to the server on port and
+ * measure every step for some seconds. The server must already run.
+ ************************************************************************/
+
+INT16 http_load_run(FILE *out, UINT16 port, UINT32 maxClients,
+		FLOAT64 seconds) {
+	HttpLoadClient *clients;
+	HttpLoadStep step;
+	struct epoll_event ev;
+	UINT32 level, target, open = 0, connected, supported = 0, i;
+	UINT64 snapshotUs, snapshotMaxUs, us;
+	UINT32 snapshots;
+	FLOAT64 latency[3], publish[3];
+	bool failed = false;
+	int epfd, fd;
+
+	clients = calloc(maxClients, sizeof(*clients));
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (clients == NULL || epfd < 0) {
+		perror("httpLoad");
+		free(clients);
+		return -1;
+	}
+	http_raise_fd_limit();
+	memset(&step, 0, sizeof(step));
+
+	fprintf(out, "http load: streams connected updates/s events/s coalesced  "
+			"p50 ms  p99 ms  max ms  publish p50/p99/max ms  "
+			"snapshot ms (max)\n");
+	for (level = 1; !failed; level *= 10) {
+		target = level < maxClients ? level : maxClients;
+
+		/* open the streams of this step */
+		while (open < target) {
+			fd = http_load_connect(port, httpLoadStream);
+			if (fd < 0) {
+				failed = true;
+				break;
+			}
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+			clients[open].fd = fd;
+			ev.events = EPOLLIN;
+			ev.data.ptr = &clients[open];
+			epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+			open++;
+		}
+		http_load_drain(epfd, HTTP_LOAD_SETTLE_US, NULL);
+
+		/* measure */
+		step.events = step.missed = step.count = 0;
+		for (i = 0; i < open; i++)
+			clients[i].seen = false;
+		http_load_drain(epfd, seconds * 1e6, &step);
+
+		snapshotUs = snapshotMaxUs = 0;
+		for (snapshots = 0; snapshots < HTTP_LOAD_SNAPSHOTS; snapshots++) {
+			us = http_load_snapshot(port);
+			if (us == 0)
+				break;
+			snapshotUs += us;
+			if (us > snapshotMaxUs)
+				snapshotMaxUs = us;
+		}
+
+		for (connected = 0, i = 0; i < open; i++)
+			connected += clients[i].fd >= 0 && clients[i].header;
+
+		http_load_percentiles(step.latency, step.count, latency);
+		http_load_percentiles(step.publish, step.count, publish);
+
+		fprintf(out, "http load: %7u %9u %9.1f %8.1f %8.1f%% %7.2f %7.2f %7.2f "
+				"%7.2f %7.2f %7.2f  %7.2f (%.2f)\n", target, connected,
+				step.events ? (step.last - step.first) / seconds : 0.0,
+				connected ? step.events / seconds / connected : 0.0,
+				step.events ? 100.0 * step.missed / (step.events + step.missed)
+						: 0.0, latency[0], latency[1], latency[2],
+				publish[0], publish[1], publish[2],
+				snapshots ? snapshotUs / 1000.0 / snapshots : 0.0,
+				snapshotMaxUs / 1000.0);
+		fflush(out);
+
+		if (connected == target && step.count > 0
+				&& latency[1] * 1000.0 < HTTP_LOAD_MAX_LATENCY_US
+				&& snapshots == HTTP_LOAD_SNAPSHOTS)
+			supported = target;
+		else
+			failed = true;
+		if (target == maxClients)
+			break;
+	}
+
+	fprintf(out, "http load: %u streams supported (all connected, p99 latency "
+			"below %u ms)\n", supported, HTTP_LOAD_MAX_LATENCY_US / 1000);
+
+	for (i = 0; i < open; i++)
+		if (clients[i].fd >= 0)
+			close(clients[i].fd);
+	close(epfd);
+	free(clients);
+	free(step.latency);
+	free(step.publish);
+	return 0;
+}
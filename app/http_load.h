@@ -0,0 +1,52 @@
+/*
+ ***************************************************************************
+ * \brief   Load generator for the embedded HTTP server
+ *	    	Opens more and more Server-Sent Events streams to a server on
+ *	    	localhost and measures for every step how many streams got
+ *	    	connected, how many updates they got and how old an update
+ *	    	was when it arrived. Server and load generator run on the
+ *	    	same host, so the sample and publication times in the update
+ *	    	can be compared with the clock of the load generator.
+ * \file    http_load.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 latency from the sample time
+ ***************************************************************************
+ */
+
+#ifndef HTTP_LOAD_H
+#define HTTP_LOAD_H
+
+#include <stdio.h>
+
+#include "http.h"
+
+/* Measurement time of every step, after the streams settled */
+#define HTTP_LOAD_SECONDS	3.0
+#define HTTP_LOAD_SETTLE_US	500000
+
+/* A step is supported if all streams connected and the p99 latency from
+ * the sample time is below */
+#define HTTP_LOAD_MAX_LATENCY_US	100000
+
+/* Snapshots requested after every step */
+#define HTTP_LOAD_SNAPSHOTS	20
+
+/* Receive buffer of a stream, holds several updates */
+#define HTTP_LOAD_BUFFER	2048
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 http_load_run(FILE *out, UINT16 port, UINT32 maxClients,
+		FLOAT64 seconds);
+
+/* #ifndef HTTP_LOAD_H */
+#endif
@@ -0,0 +1,385 @@
+/*
+ ***************************************************************************
+ * \brief   Asynchronous I2C transaction engine
+ *	    	A worker thread owns the bus. It takes all queued
+ *	    	transactions (up to the kernel message limit) and executes
+ *	    	them as one combined transfer. If a combined transfer fails
+ *	    	every transaction is retried on its own, with exponential
+ *	    	backoff, until it succeeds, runs out of retries or misses
+ *	    	its deadline. The caller never waits for the bus.
+ * \file    i2c_async.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 failed batch retried within the retry limit
+ ***************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "i2c_async.h"
+
+/* Every transaction needs at most two messages (write, read) */
+#define I2C_ASYNC_MAX_BATCH	(I2C_BUS_MAX_MSGS / 2)
+
+/*
+ ***************************************************************************
+ * Vars
+ ***************************************************************************
+ */
+
+static I2cBus *asyncBus;
+static pthread_t asyncWorker;
+static pthread_mutex_t asyncLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t asyncWork = PTHREAD_COND_INITIALIZER;
+static UINT8 asyncRunning;
+
+/* Submitted transactions, a NULL slot was expired by i2c_async_poll() */
+static I2cXfer *submitQueue[I2C_ASYNC_QUEUE_LEN];
+static UINT32 submitHead, submitCount;
+
+/* Completed transactions waiting for i2c_async_poll() */
+static I2cXfer *doneQueue[I2C_ASYNC_QUEUE_LEN];
+static UINT32 doneHead, doneCount;
+
+/* Transactions owned by the engine (queued, on the bus or done) */
+static UINT32 asyncPending;
+
+/* Failed transfers in a row, triggers the recovery hook */
+static UINT32 asyncFailures;
+
+static I2cAsyncStats asyncStats;
+
+/************************************************************************/
+/* Hand a finished transaction back to the caller (lock held)			*/
+/************************************************************************/
+
+static void async_complete_locked(I2cXfer *xfer, INT16 status, UINT64 now) {
+	UINT64 latency;
+
+	xfer->status = status;
+	xfer->completed = now;
+
+	doneQueue[(doneHead + doneCount) % I2C_ASYNC_QUEUE_LEN] = xfer;
+	doneCount++;
+
+	asyncStats.completed++;
+	if (status == -ETIMEDOUT)
+		asyncStats.timedOut++;
+	else if (status < 0)
+		asyncStats.failed++;
+
+	latency = now - xfer->submitted;
+	if (latency > asyncStats.maxLatencyUs)
+		asyncStats.maxLatencyUs = latency;
+}
+
+/************************************************************************/
+/* Execute transactions as one combined transfer (worker only)			*/
+/************************************************************************/
+
+static INT16 async_transfer(I2cXfer **xfers, UINT32 count) {
+	struct i2c_msg msgs[I2C_BUS_MAX_MSGS];
+	UINT32 i, nmsgs = 0;
+	UINT64 start;
+	INT16 status, recovered = 0;
+
+	for (i = 0; i < count; i++) {
+		if (xfers[i]->wlen) {
+			msgs[nmsgs].addr = xfers[i]->addr;
+			msgs[nmsgs].flags = 0;
+			msgs[nmsgs].len = xfers[i]->wlen;
+			msgs[nmsgs].buf = xfers[i]->wbuf;
+			nmsgs++;
+		}
+		if (xfers[i]->rlen) {
+			msgs[nmsgs].addr = xfers[i]->addr;
+			msgs[nmsgs].flags = I2C_M_RD;
+			msgs[nmsgs].len = xfers[i]->rlen;
+			msgs[nmsgs].buf = xfers[i]->rbuf;
+			nmsgs++;
+		}
+		xfers[i]->attempts++;
+	}
+
+	start = i2c_now_us();
+	for (i = 0; i < count; i++)
+		xfers[i]->started = start;
+	status = asyncBus->transfer(asyncBus, msgs, nmsgs);
+
+	if (status == 0) {
+		asyncFailures = 0;
+	} else if (++asyncFailures >= I2C_ASYNC_RECOVER_AFTER
+			&& asyncBus->recover != NULL) {
+		asyncBus->recover(asyncBus);
+		asyncFailures = 0;
+		recovered = 1;
+	}
+
+	pthread_mutex_lock(&asyncLock);
+	asyncStats.batches++;
+	if (count > asyncStats.maxBatch)
+		asyncStats.maxBatch = count;
+	asyncStats.busUs += i2c_now_us() - start;
+	asyncStats.recoveries += recovered;
+	pthread_mutex_unlock(&asyncLock);
+
+	return status;
+}
+
+/************************************************************************/
+/* Retry a single failed transaction with exponential backoff			*/
+/************************************************************************/
+
+static INT16 async_retry(I2cXfer *xfer, INT16 status) {
+	UINT32 backoff;
+
+	while (status < 0) {
+		if (xfer->attempts > xfer->retries)
+			return status;
+
+		backoff = I2C_ASYNC_BACKOFF_US << (xfer->attempts - 1);
+		if (i2c_now_us() + backoff >= xfer->deadline)
+			return -ETIMEDOUT;
+
+		usleep(backoff);
+
+		pthread_mutex_lock(&asyncLock);
+		asyncStats.retries++;
+		pthread_mutex_unlock(&asyncLock);
+
+		status = async_transfer(&xfer, 1);
+	}
+	return status;
+}
+
+/************************************************************************/
+/* Worker thread: take a batch, run it on the bus, complete it			*/
+/************************************************************************/
+
+static void *async_worker(void *unused) {
+	I2cXfer *batch[I2C_ASYNC_MAX_BATCH];
+	INT16 results[I2C_ASYNC_MAX_BATCH];
+	UINT32 i, count;
+	INT16 status;
+	UINT64 now;
+
+	(void) unused;
+
+	pthread_mutex_lock(&asyncLock);
+	while (asyncRunning) {
+		if (submitCount == 0) {
+			pthread_cond_wait(&asyncWork, &asyncLock);
+			continue;
+		}
+
+		/* Take everything that is queued, drop what is already late */
+		now = i2c_now_us();
+		count = 0;
+		while (submitCount && count < I2C_ASYNC_MAX_BATCH) {
+			I2cXfer *xfer = submitQueue[submitHead];
+
+			submitHead = (submitHead + 1) % I2C_ASYNC_QUEUE_LEN;
+			submitCount--;
+			if (xfer == NULL)
+				continue;
+			if (now >= xfer->deadline)
+				async_complete_locked(xfer, -ETIMEDOUT, now);
+			else
+				batch[count++] = xfer;
+		}
+		pthread_mutex_unlock(&asyncLock);
+
+		if (count) {
+			status = async_transfer(batch, count);
+			/*
+			 * A failed batch is retried one transaction at a time. The
+			 * batch was the first attempt of every transaction, so the
+			 * retries, the deadline and the backoff apply from the start.
+			 */
+			for (i = 0; i < count; i++)
+				results[i] = async_retry(batch[i], status);
+		}
+
+		pthread_mutex_lock(&asyncLock);
+		now = i2c_now_us();
+		for (i = 0; i < count; i++) {
+			/* Data that arrives after the deadline is no longer wanted */
+			if (results[i] == 0 && now > batch[i]->deadline)
+				results[i] = -ETIMEDOUT;
+			async_complete_locked(batch[i], results[i], now);
+		}
+	}
+	pthread_mutex_unlock(&asyncLock);
+
+	return NULL;
+}
+
+/************************************************************************/
+/* Start the engine on a bus											*/
+/************************************************************************/
+
+INT16 i2c_async_start(I2cBus *bus) {
+	if (asyncRunning)
+		return -1;
+
+	asyncBus = bus;
+	asyncRunning = 1;
+	submitHead = submitCount = 0;
+	doneHead = doneCount = 0;
+	asyncPending = 0;
+	asyncFailures = 0;
+	memset(&asyncStats, 0, sizeof(asyncStats));
+
+	if (pthread_create(&asyncWorker, NULL, async_worker, NULL) != 0) {
+		perror("i2cAsyncStart");
+		asyncRunning = 0;
+		return -1;
+	}
+	return 0;
+}
+
+/************************************************************************/
+/* Stop the engine, transactions still queued are not executed			*/
+/************************************************************************/
+
+void i2c_async_stop(void) {
+	if (!asyncRunning)
+		return;
+
+	pthread_mutex_lock(&asyncLock);
+	asyncRunning = 0;
+	pthread_cond_signal(&asyncWork);
+	pthread_mutex_unlock(&asyncLock);
+
+	pthread_join(asyncWorker, NULL);
+}
+
+/************************************************************************/
+/* Queue transactions, they go to the bus together if possible			*/
+/************************************************************************/
+
+INT16 i2c_async_submit_batch(I2cXfer **xfers, UINT32 count) {
+	UINT64 now = i2c_now_us();
+	UINT32 i;
+
+	pthread_mutex_lock(&asyncLock);
+	if (!asyncRunning || asyncPending + count > I2C_ASYNC_QUEUE_LEN) {
+		pthread_mutex_unlock(&asyncLock);
+		return -EAGAIN;
+	}
+
+	for (i = 0; i < count; i++) {
+		I2cXfer *xfer = xfers[i];
+
+		xfer->status = -EINPROGRESS;
+		xfer->attempts = 0;
+		xfer->submitted = now;
+		xfer->completed = 0;
+		xfer->deadline = now
+				+ (xfer->timeoutUs ? xfer->timeoutUs : I2C_ASYNC_TIMEOUT_US);
+
+		submitQueue[(submitHead + submitCount) % I2C_ASYNC_QUEUE_LEN] = xfer;
+		submitCount++;
+	}
+	asyncPending += count;
+	asyncStats.submitted += count;
+	pthread_cond_signal(&asyncWork);
+
+	asyncStats.stallUs += i2c_now_us() - now;
+	pthread_mutex_unlock(&asyncLock);
+
+	return 0;
+}
+
+INT16 i2c_async_submit(I2cXfer *xfer) {
+	return i2c_async_submit_batch(&xfer, 1);
+}
+
+/************************************************************************/
+/* Call the callbacks of all completed transactions. Queued ones that	*/
+/* missed their deadline complete here, even if the bus is hanging.		*/
+/* Returns the number of completed transactions.						*/
+/************************************************************************/
+
+UINT32 i2c_async_poll(void) {
+	I2cXfer *done[I2C_ASYNC_QUEUE_LEN];
+	UINT64 start = i2c_now_us(), stall;
+	UINT32 i, count = 0;
+
+	pthread_mutex_lock(&asyncLock);
+	for (i = 0; i < submitCount; i++) {
+		UINT32 slot = (submitHead + i) % I2C_ASYNC_QUEUE_LEN;
+
+		if (submitQueue[slot] != NULL && start >= submitQueue[slot]->deadline) {
+			async_complete_locked(submitQueue[slot], -ETIMEDOUT, start);
+			submitQueue[slot] = NULL;
+		}
+	}
+
+	while (doneCount) {
+		done[count++] = doneQueue[doneHead];
+		doneHead = (doneHead + 1) % I2C_ASYNC_QUEUE_LEN;
+		doneCount--;
+	}
+	asyncPending -= count;
+
+	stall = i2c_now_us() - start;
+	asyncStats.stallUs += stall;
+	if (stall > asyncStats.maxStallUs)
+		asyncStats.maxStallUs = stall;
+	pthread_mutex_unlock(&asyncLock);
+
+	for (i = 0; i < count; i++)
+		if (done[i]->callback != NULL)
+			done[i]->callback(done[i], done[i]->status, done[i]->arg);
+
+	return count;
+}
+
+/************************************************************************/
+/* Number of transactions not yet returned by i2c_async_poll()			*/
+/************************************************************************/
+
+UINT32 i2c_async_pending(void) {
+	UINT32 pending;
+
+	pthread_mutex_lock(&asyncLock);
+	pending = asyncPending;
+	pthread_mutex_unlock(&asyncLock);
+
+	return pending;
+}
+
+/************************************************************************/
+/* Statistics															*/
+/************************************************************************/
+
+void i2c_async_get_stats(I2cAsyncStats *stats) {
+	pthread_mutex_lock(&asyncLock);
+	*stats = asyncStats;
+	pthread_mutex_unlock(&asyncLock);
+}
+
+void i2c_async_print_stats(FILE *out) {
+	I2cAsyncStats s;
+
+	i2c_async_get_stats(&s);
+
+	fprintf(out, "i2c: %u submitted, %u completed, %u failed, %u timed out\n",
+			s.submitted, s.completed, s.failed, s.timedOut);
+	fprintf(out, "i2c: %u retries, %u bus recoveries, %u batches (max %u)\n",
+			s.retries, s.recoveries, s.batches, s.maxBatch);
+	fprintf(out, "i2c: bus busy %llu us, max latency %llu us\n",
+			s.busUs, s.maxLatencyUs);
+	fprintf(out, "i2c: caller stalled %llu us in total, %llu us at most\n",
+			s.stallUs, s.maxStallUs);
+}
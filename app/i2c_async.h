@@ -0,0 +1,114 @@
+/*
+ ***************************************************************************
+ * \brief   Asynchronous I2C transaction engine
+ *	    	Transactions are queued by the caller and executed by a
+ *	    	worker thread. Queued transactions are batched into one
+ *	    	combined transfer, failed ones are retried with backoff
+ *	    	until their deadline and completions are handed back to the
+ *	    	caller by i2c_async_poll().
+ * \file    i2c_async.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef I2C_ASYNC_H
+#define I2C_ASYNC_H
+
+#include <stdio.h>
+
+#include "i2c_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of transactions queued at the same time */
+#define I2C_ASYNC_QUEUE_LEN	64
+
+/* Maximum number of bytes written / read by one transaction */
+#define I2C_XFER_WMAX		4
+#define I2C_XFER_RMAX		8
+
+/* Default deadline and retries of a transaction */
+#define I2C_ASYNC_TIMEOUT_US	20000
+#define I2C_ASYNC_RETRIES	3
+
+/* Backoff before retry n is I2C_ASYNC_BACKOFF_US << n */
+#define I2C_ASYNC_BACKOFF_US	200
+
+/* Call the recovery hook after this many failed transfers in a row */
+#define I2C_ASYNC_RECOVER_AFTER	2
+
+typedef struct I2cXfer I2cXfer;
+
+/* Completion callback, status is 0 or a negative errno value */
+typedef void (*I2cXferCallback)(I2cXfer *xfer, INT16 status, void *arg);
+
+/*
+ * One transaction: write wlen bytes then (repeated start) read rlen
+ * bytes from the slave addr. The structure is owned by the engine from
+ * i2c_async_submit() until its callback has been called.
+ */
+struct I2cXfer {
+	/* filled by the caller */
+	UINT8  addr;
+	UINT8  wbuf[I2C_XFER_WMAX];
+	UINT16 wlen;
+	UINT8  rbuf[I2C_XFER_RMAX];
+	UINT16 rlen;
+	UINT32 timeoutUs;	/* 0 selects I2C_ASYNC_TIMEOUT_US */
+	UINT8  retries;
+	I2cXferCallback callback;
+	void  *arg;
+
+	/* filled by the engine */
+	INT16  status;
+	UINT8  attempts;
+	UINT64 submitted;
+	UINT64 started;		/* start of the (last) bus transfer */
+	UINT64 deadline;
+	UINT64 completed;
+};
+
+/* Engine statistics, all times in microseconds */
+typedef struct {
+	UINT32 submitted;
+	UINT32 completed;
+	UINT32 failed;
+	UINT32 timedOut;
+	UINT32 retries;
+	UINT32 recoveries;
+	UINT32 batches;		/* combined transfers handed to the bus */
+	UINT32 maxBatch;	/* most transactions in one transfer */
+	UINT64 busUs;		/* time spent inside bus transfers */
+	UINT64 maxLatencyUs;	/* submit to completion */
+	UINT64 stallUs;		/* time the caller spent in submit/poll */
+	UINT64 maxStallUs;
+} I2cAsyncStats;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 i2c_async_start(I2cBus *bus);
+extern void  i2c_async_stop(void);
+extern INT16 i2c_async_submit(I2cXfer *xfer);
+extern INT16 i2c_async_submit_batch(I2cXfer **xfers, UINT32 count);
+extern UINT32 i2c_async_poll(void);
+extern UINT32 i2c_async_pending(void);
+extern void  i2c_async_get_stats(I2cAsyncStats *stats);
+extern void  i2c_async_print_stats(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* #ifndef I2C_ASYNC_H */
+#endif
@@ -0,0 +1,162 @@
+/*
+ ***************************************************************************
+ * \brief   I2C bus abstraction
+ *	    	Backend for the Linux i2c-dev driver. All messages of one
+ *	    	transfer are handed to the kernel with a single I2C_RDWR
+ *	    	ioctl.
+ * \file    i2c_bus.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 transfer and recovery serialized by a mutex
+ ***************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <sys/ioctl.h>
+
+#include "i2c_bus.h"
+
+/* Kernel side timeout of one transfer in units of 10 ms */
+#define I2C_DEV_TIMEOUT_10MS	5
+
+/* Private data of the i2c-dev backend */
+typedef struct {
+	I2cBus bus;
+	char   device[64];
+	INT32  fd;
+	pthread_mutex_t lock;	/* fd is replaced by a recovery */
+} I2cDevBus;
+
+/************************************************************************/
+/* Monotonic time in microseconds										*/
+/************************************************************************/
+
+UINT64 i2c_now_us(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (UINT64) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/************************************************************************/
+/* Open the device and bound the time the kernel waits for the bus		*/
+/************************************************************************/
+
+static INT32 i2c_dev_open_fd(const char *device) {
+	INT32 fd;
+
+	fd = open(device, O_RDWR);
+	if (fd < 0) {
+		perror("i2cDevOpen");
+		return -1;
+	}
+
+	/* Without this a stuck slave can block I2C_RDWR for a long time */
+	if (ioctl(fd, I2C_TIMEOUT, I2C_DEV_TIMEOUT_10MS) < 0)
+		perror("i2cDevTimeout");
+
+	/* Retries are done by the async engine, not by the adapter */
+	if (ioctl(fd, I2C_RETRIES, 0) < 0)
+		perror("i2cDevRetries");
+
+	return fd;
+}
+
+/************************************************************************/
+/* Execute all messages with one I2C_RDWR ioctl							*/
+/************************************************************************/
+
+static INT16 i2c_dev_transfer(I2cBus *bus, struct i2c_msg *msgs, UINT32 nmsgs) {
+	I2cDevBus *dev = bus->priv;
+	struct i2c_rdwr_ioctl_data data;
+	INT16 status = 0;
+
+	data.msgs = msgs;
+	data.nmsgs = nmsgs;
+
+	pthread_mutex_lock(&dev->lock);
+	if (dev->fd < 0)
+		status = -ENODEV;
+	else if (ioctl(dev->fd, I2C_RDWR, &data) < 0)
+		status = -errno;
+	pthread_mutex_unlock(&dev->lock);
+
+	return status;
+}
+
+/************************************************************************/
+/* Reopen the device, this resets the adapter state of the driver. The	*/
+/* lock keeps a transfer of another thread off the closed (or reused)	*/
+/* fd.																	*/
+/************************************************************************/
+
+static INT16 i2c_dev_recover(I2cBus *bus) {
+	I2cDevBus *dev = bus->priv;
+	INT16 status = 0;
+
+	pthread_mutex_lock(&dev->lock);
+	if (dev->fd >= 0)
+		close(dev->fd);
+
+	dev->fd = i2c_dev_open_fd(dev->device);
+	if (dev->fd < 0)
+		status = -ENODEV;
+	pthread_mutex_unlock(&dev->lock);
+
+	return status;
+}
+
+/************************************************************************/
+/* Close the device and free the bus									*/
+/************************************************************************/
+
+static void i2c_dev_close(I2cBus *bus) {
+	I2cDevBus *dev = bus->priv;
+
+	if (dev->fd >= 0)
+		close(dev->fd);
+	pthread_mutex_destroy(&dev->lock);
+	free(dev);
+}
+
+/************************************************************************/
+/* Open a Linux i2c-dev bus												*/
+/************************************************************************/
+
+I2cBus *i2c_dev_bus_open(const char *device) {
+	I2cDevBus *dev;
+
+	dev = calloc(1, sizeof(*dev));
+	if (dev == NULL) {
+		perror("i2cDevBusOpen");
+		return NULL;
+	}
+
+	strncpy(dev->device, device, sizeof(dev->device) - 1);
+	dev->fd = i2c_dev_open_fd(device);
+	if (dev->fd < 0) {
+		free(dev);
+		return NULL;
+	}
+
+	pthread_mutex_init(&dev->lock, NULL);
+	dev->bus.name = dev->device;
+	dev->bus.transfer = i2c_dev_transfer;
+	dev->bus.recover = i2c_dev_recover;
+	dev->bus.close = i2c_dev_close;
+	dev->bus.priv = dev;
+
+	return &dev->bus;
+}
@@ -0,0 +1,88 @@
+/*
+ ***************************************************************************
+ * \brief   I2C bus abstraction
+ *	    	A bus is anything that can execute a list of i2c messages in
+ *	    	one combined transfer: the Linux i2c-dev driver or the
+ *	    	simulated TCS3414 (see i2c_sim.h).
+ * \file    i2c_bus.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 transfer() and recover() from several threads
+ ***************************************************************************
+ */
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ ***************************************************************************
+ * Define some data types
+ ***************************************************************************
+ */
+
+typedef signed char INT8;
+typedef unsigned char UINT8;
+
+typedef signed short INT16;
+typedef unsigned short UINT16;
+
+typedef signed int INT32;
+typedef unsigned int UINT32;
+
+typedef signed long long INT64;
+typedef unsigned long long UINT64;
+
+typedef float FLOAT32;
+typedef double FLOAT64;
+
+/* Linux i2c-dev device used by the BBB-BFH-Cape */
+#define I2C_BUS_DEVICE		"/dev/i2c-1"
+
+/* Kernel limit of messages per I2C_RDWR ioctl */
+#define I2C_BUS_MAX_MSGS	I2C_RDWR_IOCTL_MAX_MSGS
+
+/*
+ * A bus executes all messages in one combined transfer (repeated start
+ * between the messages). transfer() returns 0 on success or a negative
+ * errno value, recover() tries to bring a hung bus back (may be NULL).
+ * Both may be called from several threads (the async worker and a
+ * synchronous caller), the backend serializes them.
+ */
+typedef struct I2cBus I2cBus;
+
+struct I2cBus {
+	const char *name;
+	INT16 (*transfer)(I2cBus *bus, struct i2c_msg *msgs, UINT32 nmsgs);
+	INT16 (*recover)(I2cBus *bus);
+	void  (*close)(I2cBus *bus);
+	void  *priv;
+};
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern I2cBus *i2c_dev_bus_open(const char *device);
+extern UINT64  i2c_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* #ifndef I2C_BUS_H */
+#endif
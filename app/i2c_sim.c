@@ -0,0 +1,436 @@
+/*
+ ***************************************************************************
+ * \brief   Simulated TCS3414 on a fault injecting I2C bus
+ *	    	Models the register file of the sensor (command byte with
+ *	    	register pointer, control, timing, gain and the four data
+ *	    	channels) behind a bus that injects faults on request.
+ *	    	The light can step and flicker, the integration can be
+ *	    	free running or manual.
+ * \file    i2c_sim.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 wrong manual integration sequence rejected
+ *          19.10.2026 timing/gain writes keep the last frame and ADC_VALID
+ ***************************************************************************
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <math.h>
+
+#include "i2c_sim.h"
+#include "TCS3414.h"
+
+/* Number of registers addressable by the command byte */
+#define SIM_NUM_REGS		0x20
+
+/* Light seen by the simulated sensor in counts per ms at gain 1x */
+static const FLOAT32 simLevel[4] = { 30.0, 20.0, 15.0, 70.0 };	/* G, R, B, C */
+
+/* Private data of the simulated bus */
+typedef struct {
+	I2cBus          bus;
+	pthread_mutex_t lock;
+	I2cSimFaults    faults;
+	I2cSimStats     stats;
+	UINT32          rand;
+	UINT8           hung;
+	UINT8           ptr;
+	UINT64          integStart;	/* start of the first integration cycle */
+	UINT64          cycle;		/* cycle latched in the data registers */
+	UINT64          stepStart;	/* the light steps every stepUs from here */
+	UINT32          stepUs;
+	FLOAT32         stepFactor;
+	UINT64          flickerStart;
+	FLOAT32         flickerHz;	/* 0: steady light */
+	FLOAT32         flickerDepth;
+	FLOAT32         flickerDuty;	/* 0: sine, else PWM with this duty cycle */
+	UINT8           regs[SIM_NUM_REGS];
+} I2cSimBus;
+
+/************************************************************************/
+/* Random number 0..999 for the fault injection							*/
+/************************************************************************/
+
+static UINT32 sim_permille(I2cSimBus *sim) {
+	return rand_r(&sim->rand) % 1000;
+}
+
+/************************************************************************/
+/* Time the PWM of the flicker was on from flickerStart to t			*/
+/************************************************************************/
+
+static FLOAT64 sim_pwm_on(const I2cSimBus *sim, FLOAT64 t) {
+	FLOAT64 period = 1.0 / sim->flickerHz, on = sim->flickerDuty * period;
+	FLOAT64 periods = floor(t / period);
+
+	return periods * on + fmin(t - periods * period, on);
+}
+
+/************************************************************************/
+/* Mean light from start to end (relative to the level of simLevel)		*/
+/************************************************************************/
+
+static FLOAT64 sim_light(const I2cSimBus *sim, UINT64 start, UINT64 end) {
+	FLOAT64 light = 1.0, t0, t1, omega;
+
+	/* every second step period the light is brighter */
+	if (sim->stepUs && ((end - sim->stepStart) / sim->stepUs) % 2)
+		light = sim->stepFactor;
+
+	if (sim->flickerHz <= 0.0 || end <= start)
+		return light;
+
+	t0 = (start - sim->flickerStart) / 1e6;
+	t1 = (end - sim->flickerStart) / 1e6;
+	if (sim->flickerDuty > 0.0)
+		/* PWM between full and (1 - depth) */
+		return light * (1.0 - sim->flickerDepth + sim->flickerDepth
+				* (sim_pwm_on(sim, t1) - sim_pwm_on(sim, t0)) / (t1 - t0));
+
+	/* 1 + depth * sin(omega t), averaged over the integration */
+	omega = 2.0 * M_PI * sim->flickerHz;
+	return light * (1.0 + sim->flickerDepth
+			* (cos(omega * t0) - cos(omega * t1)) / (omega * (t1 - t0)));
+}
+
+/************************************************************************/
+/* Convert the light of one integration into the data registers			*/
+/************************************************************************/
+
+static void sim_latch(I2cSimBus *sim, UINT64 start, UINT64 end) {
+	UINT32 channel, value, integUs, gain, fullScale;
+	FLOAT32 noise, light;
+
+	integUs = end - start;
+	gain = TCS3414_GainFactor(sim->regs[TCS3414_GAIN]);
+	fullScale = integUs * TCS3414_COUNTS_PER_US;
+	if (fullScale > TCS3414_FULL_SCALE)
+		fullScale = TCS3414_FULL_SCALE;
+	light = sim_light(sim, start, end);
+
+	for (channel = 0; channel < 4; channel++) {
+		/* +-1% noise on every channel */
+		noise = 1.0 + ((FLOAT32) (rand_r(&sim->rand) % 201) - 100.0) / 10000.0;
+		value = (UINT32) (simLevel[channel] * light * integUs / 1000.0 * gain
+				* noise);
+		if (value > fullScale)
+			value = fullScale;
+		sim->regs[TCS3414_DATA1LOW + 2 * channel] = value & 0xFF;
+		sim->regs[TCS3414_DATA1HIGH + 2 * channel] = value >> 8;
+	}
+	sim->regs[TCS3414_CONTROL] |= TCS3414_ADC_VALID;
+}
+
+/************************************************************************/
+/* Latch new ADC values into the data registers at the end of every		*/
+/* integration cycle													*/
+/************************************************************************/
+
+static void sim_update_data(I2cSimBus *sim, UINT64 now) {
+	UINT32 integUs;
+	UINT64 cycle;
+
+	/* Nothing is converted while the sensor is off, and in manual mode
+	 * only when ADC_EN is cleared (see sim_message()) */
+	if ((sim->regs[TCS3414_CONTROL] & TCS3414_POWER_ON_ADC_EN)
+			!= TCS3414_POWER_ON_ADC_EN
+			|| (sim->regs[TCS3414_TIMING] & TCS3414_INTEG_MODE_MASK)
+					== TCS3414_INTEG_MANUAL)
+		return;
+
+	integUs = TCS3414_IntegrationUs(sim->regs[TCS3414_TIMING]);
+	cycle = (now - sim->integStart) / integUs;
+	if (cycle == 0 || cycle == sim->cycle)
+		return;
+	sim->cycle = cycle;
+
+	sim_latch(sim, sim->integStart + (cycle - 1) * integUs,
+			sim->integStart + cycle * integUs);
+}
+
+/************************************************************************/
+/* Start a new integration, the data is invalid until it is complete	*/
+/************************************************************************/
+
+static void sim_restart_integration(I2cSimBus *sim, UINT64 now) {
+	sim->integStart = now;
+	sim->cycle = 0;
+	sim->regs[TCS3414_CONTROL] &= ~TCS3414_ADC_VALID;
+}
+
+/************************************************************************/
+/* The datasheet sequence of manual integration: INTEG_MODE is written	*/
+/* while ADC_EN is 0, an integration starts with a rising edge of		*/
+/* ADC_EN. The real sensor misbehaves silently, the simulation rejects	*/
+/* the write so the wrong order shows up as an error.					*/
+/************************************************************************/
+
+static bool sim_allowed(I2cSimBus *sim, UINT32 reg, UINT8 value) {
+	bool enabled = sim->regs[TCS3414_CONTROL] & TCS3414_ADC_EN;
+	bool manual = (sim->regs[TCS3414_TIMING] & TCS3414_INTEG_MODE_MASK)
+			== TCS3414_INTEG_MANUAL;
+
+	if (reg == TCS3414_TIMING && enabled
+			&& (value & TCS3414_INTEG_MODE_MASK) != TCS3414_INTEG_FREE) {
+		fprintf(stderr, "sim: INTEG_MODE written while ADC_EN is set\n");
+		return false;
+	}
+	if (reg == TCS3414_CONTROL && manual && enabled
+			&& (value & TCS3414_ADC_EN)) {
+		fprintf(stderr, "sim: manual integration started without ADC_EN at 0\n");
+		return false;
+	}
+	return true;
+}
+
+/************************************************************************/
+/* Execute one message on the register file								*/
+/************************************************************************/
+
+static INT16 sim_message(I2cSimBus *sim, struct i2c_msg *msg, UINT64 now) {
+	UINT32 i, reg;
+	UINT8 control;
+
+	if (msg->addr != TCS3414_I2C_ADDR)
+		return -ENXIO;
+
+	/* The register pointer only advances within one message */
+	if (msg->flags & I2C_M_RD) {
+		for (i = 0; i < msg->len; i++)
+			msg->buf[i] = sim->regs[(sim->ptr + i) % SIM_NUM_REGS];
+		return 0;
+	}
+
+	if (msg->len == 0)
+		return 0;
+
+	/* A command byte sets the register pointer, without the command
+	 * bit the byte is data for the register selected before (this is
+	 * how TCS3414_Init() writes the control register) */
+	i = 0;
+	if (msg->buf[0] & TCS3414_COMMAND) {
+		sim->ptr = msg->buf[0] & TCS3414_ADDRESS_MASK;
+		i = 1;
+	}
+
+	/* Remaining bytes are written to the registers */
+	for (reg = sim->ptr; i < msg->len; i++, reg = (reg + 1) % SIM_NUM_REGS) {
+		if (!sim_allowed(sim, reg, msg->buf[i])) {
+			sim->stats.rejected++;
+			return -EINVAL;
+		}
+		if (reg == TCS3414_CONTROL) {
+			control = sim->regs[reg];
+			sim->regs[reg] = (control & TCS3414_ADC_VALID)
+					| (msg->buf[i] & TCS3414_POWER_ON_ADC_EN);
+			/* enabling the ADC starts the first integration */
+			if ((control & TCS3414_POWER_ON_ADC_EN) != TCS3414_POWER_ON_ADC_EN
+					&& (msg->buf[i] & TCS3414_POWER_ON_ADC_EN)
+							== TCS3414_POWER_ON_ADC_EN)
+				sim_restart_integration(sim, now);
+			/* in manual mode disabling it ends the integration */
+			else if (!(msg->buf[i] & TCS3414_ADC_EN)
+					&& (sim->regs[TCS3414_TIMING] & TCS3414_INTEG_MODE_MASK)
+							== TCS3414_INTEG_MANUAL)
+				sim_latch(sim, sim->integStart, now);
+		} else if (reg == TCS3414_TIMING || reg == TCS3414_GAIN) {
+			/* The datasheet does not say what a write does to a running
+			 * integration. The simulation takes the pessimistic view: a
+			 * new cycle starts, but the data and ADC_VALID of the last
+			 * one stay, so a frame read too early has the old setting. */
+			sim->regs[reg] = msg->buf[i];
+			sim->integStart = now;
+			sim->cycle = 0;
+		} else if (reg < TCS3414_DATA1LOW) {
+			sim->regs[reg] = msg->buf[i];
+		}
+	}
+	return 0;
+}
+
+/************************************************************************/
+/* Execute a combined transfer, injecting faults as configured			*/
+/************************************************************************/
+
+static INT16 sim_transfer(I2cBus *bus, struct i2c_msg *msgs, UINT32 nmsgs) {
+	I2cSimBus *sim = bus->priv;
+	INT16 status = 0;
+	UINT32 i, dice, stallUs = 0;
+	UINT64 now;
+
+	pthread_mutex_lock(&sim->lock);
+	sim->stats.transfers++;
+
+	dice = sim_permille(sim);
+	if (!sim->hung && dice < sim->faults.hangPermille) {
+		sim->hung = 1;
+		sim->stats.hung++;
+	}
+
+	if (sim->hung) {
+		/* A hung bus times out on every transfer until recovered */
+		stallUs = sim->faults.stallUs;
+		status = -ETIMEDOUT;
+	} else if (sim_permille(sim) < sim->faults.failPermille) {
+		sim->stats.failed++;
+		status = -EIO;
+	} else {
+		if (sim_permille(sim) < sim->faults.stallPermille) {
+			sim->stats.stalled++;
+			stallUs = sim->faults.stallUs;
+		}
+		now = i2c_now_us();
+		sim_update_data(sim, now);
+		for (i = 0; i < nmsgs && status == 0; i++)
+			status = sim_message(sim, &msgs[i], now);
+	}
+	sim->stats.stallUs += stallUs;
+	pthread_mutex_unlock(&sim->lock);
+
+	/* Stall outside of the lock, the bus is blocked not the simulator */
+	if (stallUs)
+		usleep(stallUs);
+
+	return status;
+}
+
+/************************************************************************/
+/* Bus recovery (the nine clock pulses on real hardware)				*/
+/************************************************************************/
+
+static INT16 sim_recover(I2cBus *bus) {
+	I2cSimBus *sim = bus->priv;
+
+	pthread_mutex_lock(&sim->lock);
+	if (sim->hung) {
+		sim->hung = 0;
+		sim->stats.recovered++;
+	}
+	pthread_mutex_unlock(&sim->lock);
+
+	return 0;
+}
+
+/************************************************************************/
+/* Free the simulated bus												*/
+/************************************************************************/
+
+static void sim_close(I2cBus *bus) {
+	I2cSimBus *sim = bus->priv;
+
+	pthread_mutex_destroy(&sim->lock);
+	free(sim);
+}
+
+/************************************************************************/
+/* Open a simulated bus with a TCS3414 at TCS3414_I2C_ADDR				*/
+/************************************************************************/
+
+I2cBus *i2c_sim_bus_open(const I2cSimFaults *faults) {
+	I2cSimBus *sim;
+
+	sim = calloc(1, sizeof(*sim));
+	if (sim == NULL) {
+		perror("i2cSimBusOpen");
+		return NULL;
+	}
+
+	if (faults != NULL)
+		sim->faults = *faults;
+	sim->rand = sim->faults.seed;
+	pthread_mutex_init(&sim->lock, NULL);
+
+	sim->bus.name = "simulated TCS3414";
+	sim->bus.transfer = sim_transfer;
+	sim->bus.recover = sim_recover;
+	sim->bus.close = sim_close;
+	sim->bus.priv = sim;
+
+	return &sim->bus;
+}
+
+/************************************************************************/
+/* Simulate a sensor that was left running with the given timing and	*/
+/* gain, e.g. by the last instance of the program						*/
+/************************************************************************/
+
+void i2c_sim_power_on(I2cBus *bus, UINT8 timing, UINT8 gain) {
+	I2cSimBus *sim = bus->priv;
+	UINT64 now = i2c_now_us();
+
+	pthread_mutex_lock(&sim->lock);
+	sim->regs[TCS3414_CONTROL] = TCS3414_POWER_ON_ADC_EN;
+	sim->regs[TCS3414_TIMING] = timing;
+	sim->regs[TCS3414_GAIN] = gain;
+	sim_restart_integration(sim, now - TCS3414_IntegrationUs(timing));
+	sim_update_data(sim, now);
+	pthread_mutex_unlock(&sim->lock);
+}
+
+/************************************************************************/
+/* Let the light step between its level and factor times its level		*/
+/* every stepUs (0 switches the steps off)								*/
+/************************************************************************/
+
+void i2c_sim_set_steps(I2cBus *bus, UINT32 stepUs, FLOAT32 factor) {
+	I2cSimBus *sim = bus->priv;
+
+	pthread_mutex_lock(&sim->lock);
+	sim->stepStart = i2c_now_us();
+	sim->stepUs = stepUs;
+	sim->stepFactor = factor;
+	pthread_mutex_unlock(&sim->lock);
+}
+
+/************************************************************************/
+/* Let the light flicker at freqHz: a sine with the given depth, or a	*/
+/* PWM between full and (1 - depth) if duty is set (0 switches it off)	*/
+/************************************************************************/
+
+void i2c_sim_set_flicker(I2cBus *bus, FLOAT32 freqHz, FLOAT32 depth,
+		FLOAT32 duty) {
+	I2cSimBus *sim = bus->priv;
+
+	pthread_mutex_lock(&sim->lock);
+	sim->flickerStart = i2c_now_us();
+	sim->flickerHz = freqHz;
+	sim->flickerDepth = depth;
+	sim->flickerDuty = duty;
+	pthread_mutex_unlock(&sim->lock);
+}
+
+/************************************************************************/
+/* Time of the last step of the light, 0 if there was none				*/
+/************************************************************************/
+
+UINT64 i2c_sim_last_step(I2cBus *bus) {
+	I2cSimBus *sim = bus->priv;
+	UINT64 steps;
+
+	if (sim->stepUs == 0)
+		return 0;
+
+	steps = (i2c_now_us() - sim->stepStart) / sim->stepUs;
+	return steps ? sim->stepStart + steps * sim->stepUs : 0;
+}
+
+/************************************************************************/
+/* Read the transfer statistics of a simulated bus						*/
+/************************************************************************/
+
+void i2c_sim_get_stats(I2cBus *bus, I2cSimStats *stats) {
+	I2cSimBus *sim = bus->priv;
+
+	pthread_mutex_lock(&sim->lock);
+	*stats = sim->stats;
+	pthread_mutex_unlock(&sim->lock);
+}
@@ -0,0 +1,58 @@
+/*
+ ***************************************************************************
+ * \brief   Simulated TCS3414 on a fault injecting I2C bus
+ *	    	Lets the application and the async i2c engine run without
+ *	    	the BBB-BFH-Cape. Transfers can be made to fail, to stall or
+ *	    	to hang the bus until it is recovered.
+ * \file    i2c_sim.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 wrong manual integration sequence rejected
+ ***************************************************************************
+ */
+
+#ifndef I2C_SIM_H
+#define I2C_SIM_H
+
+#include "i2c_bus.h"
+
+/* Fault injection, all rates in per mille of the transfers */
+typedef struct {
+	UINT32 failPermille;	/* transfer fails immediately with EIO */
+	UINT32 stallPermille;	/* transfer succeeds after stallUs */
+	UINT32 hangPermille;	/* bus hangs until recover() is called */
+	UINT32 stallUs;		/* duration of a stall (also used by a hang) */
+	UINT32 seed;		/* seed of the fault and noise generator */
+} I2cSimFaults;
+
+/* Transfer statistics of the simulated bus */
+typedef struct {
+	UINT32 transfers;
+	UINT32 failed;
+	UINT32 stalled;
+	UINT32 hung;
+	UINT32 recovered;
+	UINT32 rejected;	/* writes in an order the datasheet forbids */
+	UINT64 stallUs;		/* total time the bus was stalled or hung */
+} I2cSimStats;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern I2cBus *i2c_sim_bus_open(const I2cSimFaults *faults);
+extern void    i2c_sim_power_on(I2cBus *bus, UINT8 timing, UINT8 gain);
+extern void    i2c_sim_set_steps(I2cBus *bus, UINT32 stepUs, FLOAT32 factor);
+extern UINT64  i2c_sim_last_step(I2cBus *bus);
+extern void    i2c_sim_set_flicker(I2cBus *bus, FLOAT32 freqHz, FLOAT32 depth,
+		FLOAT32 duty);
+extern void    i2c_sim_get_stats(I2cBus *bus, I2cSimStats *stats);
+
+/* #ifndef I2C_SIM_H */
+#endif
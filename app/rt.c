@@ -0,0 +1,147 @@
+/*
+ ***************************************************************************
+ * \brief   Real-time execution and loop jitter
+ *	    	The period error of every wakeup (actual minus nominal
+ *	    	period) goes into a log2 histogram, the latency (actual
+ *	    	minus requested wakeup time) is kept as maximum and mean.
+ * \file    rt.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <sys/mman.h>
+
+#include "rt.h"
+
+/************************************************************************/
+/* Touch the stack so its pages are mapped (and locked) now				*/
+/************************************************************************/
+
+static void rt_prefault_stack(void) {
+	volatile UINT8 stack[RT_STACK_PREFAULT];
+
+	memset((void *) stack, 0, sizeof(stack));
+}
+
+/************************************************************************
+ * Lock all current and future memory, pin the calling thread to cpu
+ * (if cpu >= 0) and switch it to SCHED_FIFO. Call it after everything
+ * the loop uses has been allocated and before the i2c worker is
+ * started, so the worker inherits core and policy.
+ ************************************************************************/
+
+INT16 rt_enable(INT32 cpu, INT32 priority) {
+	struct sched_param param;
+	cpu_set_t cpus;
+	int error;
+
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+		perror("rtMlockall");
+		return -1;
+	}
+	rt_prefault_stack();
+
+	if (cpu >= 0) {
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu, &cpus);
+		error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		if (error) {
+			errno = error;
+			perror("rtAffinity");
+			return -1;
+		}
+	}
+
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = priority;
+	error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	if (error) {
+		errno = error;
+		perror("rtSchedFifo");
+		return -1;
+	}
+	return 0;
+}
+
+/************************************************************************/
+/* Advance an absolute time by some microseconds						*/
+/************************************************************************/
+
+void rt_add_us(struct timespec *ts, UINT32 us) {
+	ts->tv_nsec += (long) us * 1000;
+	while (ts->tv_nsec >= 1000000000L) {
+		ts->tv_nsec -= 1000000000L;
+		ts->tv_sec++;
+	}
+}
+
+/************************************************************************/
+/* Jitter measurement													*/
+/************************************************************************/
+
+void rt_jitter_init(RtJitter *jitter, UINT32 periodUs) {
+	memset(jitter, 0, sizeof(*jitter));
+	jitter->periodUs = periodUs;
+}
+
+void rt_jitter_wakeup(RtJitter *jitter, UINT64 requestedUs, UINT64 nowUs) {
+	UINT64 latency, period, error;
+	UINT32 bucket;
+
+	latency = nowUs > requestedUs ? nowUs - requestedUs : 0;
+	jitter->sumLatencyUs += latency;
+	if (latency > jitter->maxLatencyUs)
+		jitter->maxLatencyUs = latency;
+
+	if (jitter->wakeups++ > 0) {
+		period = nowUs - jitter->lastUs;
+		if (jitter->minPeriodUs == 0 || period < jitter->minPeriodUs)
+			jitter->minPeriodUs = period;
+		if (period > jitter->maxPeriodUs)
+			jitter->maxPeriodUs = period;
+
+		error = period > jitter->periodUs ? period - jitter->periodUs
+				: jitter->periodUs - period;
+		for (bucket = 0; bucket < RT_JITTER_BUCKETS - 1
+				&& error >= (1ULL << bucket); bucket++)
+			;
+		jitter->bucket[bucket]++;
+	}
+	jitter->lastUs = nowUs;
+}
+
+void rt_jitter_print(FILE *out, const char *title, const RtJitter *jitter) {
+	UINT32 i, last = 0;
+
+	fprintf(out, "%s: %llu wakeups, period %u us (min %llu, max %llu)\n",
+			title, jitter->wakeups, jitter->periodUs, jitter->minPeriodUs,
+			jitter->maxPeriodUs);
+	fprintf(out, "%s: latency max %llu us, mean %.1f us\n", title,
+			jitter->maxLatencyUs, jitter->wakeups
+					? (FLOAT64) jitter->sumLatencyUs / jitter->wakeups : 0.0);
+
+	for (i = 0; i < RT_JITTER_BUCKETS; i++)
+		if (jitter->bucket[i])
+			last = i;
+
+	fprintf(out, "%s: period error histogram\n", title);
+	for (i = 0; i <= last; i++) {
+		if (i == RT_JITTER_BUCKETS - 1)
+			fprintf(out, "  >= %7u us: %u\n", 1U << (i - 1), jitter->bucket[i]);
+		else
+			fprintf(out, "  < %8u us: %u\n", 1U << i, jitter->bucket[i]);
+	}
+}
@@ -0,0 +1,59 @@
+/*
+ ***************************************************************************
+ * \brief   Real-time execution and loop jitter
+ *	    	Locks the memory, pins the calling thread to one core and
+ *	    	runs it under SCHED_FIFO. Threads created afterwards (the
+ *	    	i2c worker) inherit all of it. The jitter measurement works
+ *	    	with or without real-time mode, so both can be compared.
+ * \file    rt.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef RT_H
+#define RT_H
+
+#include <stdio.h>
+#include <time.h>
+
+#include "i2c_bus.h"
+
+/* SCHED_FIFO priority of the acquisition */
+#define RT_PRIORITY		80
+
+/* Stack touched before the loop so it never page faults */
+#define RT_STACK_PREFAULT	(64 * 1024)
+
+/* Histogram of the period error: <1us, <2us, <4us ... and the rest */
+#define RT_JITTER_BUCKETS	20
+
+typedef struct {
+	UINT32 periodUs;	/* nominal period */
+	UINT64 wakeups;
+	UINT64 lastUs;		/* last wakeup */
+	UINT64 maxLatencyUs;	/* wakeup later than requested */
+	UINT64 sumLatencyUs;
+	UINT64 minPeriodUs;
+	UINT64 maxPeriodUs;
+	UINT32 bucket[RT_JITTER_BUCKETS];
+} RtJitter;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 rt_enable(INT32 cpu, INT32 priority);
+extern void  rt_add_us(struct timespec *ts, UINT32 us);
+extern void  rt_jitter_init(RtJitter *jitter, UINT32 periodUs);
+extern void  rt_jitter_wakeup(RtJitter *jitter, UINT64 requestedUs, UINT64 nowUs);
+extern void  rt_jitter_print(FILE *out, const char *title, const RtJitter *jitter);
+
+/* #ifndef RT_H */
+#endif
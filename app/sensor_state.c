@@ -0,0 +1,88 @@
+/*
+ ***************************************************************************
+ * \brief   Persisted sensor configuration
+ *	    	The file holds one "name value" pair per line, e.g.
+ *	    	"timing 0x01" and "gain 0x10". It is replaced atomically
+ *	    	(write to a temporary file, then rename) so a power loss
+ *	    	never leaves a half written file behind.
+ * \file    sensor_state.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 configuration only changed by a complete file
+ ***************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sensor_state.h"
+
+/************************************************************************/
+/* Load the configuration, returns -1 if there is no valid state file:	*/
+/* a value out of range, a line that does not parse (e.g. a truncated	*/
+/* file) or a missing value. config is only written if the whole file	*/
+/* is valid.															*/
+/************************************************************************/
+
+INT16 sensor_state_load(const char *path, TCS3414_Config *config) {
+	TCS3414_Config loaded;
+	FILE *file;
+	char name[16];
+	unsigned int value;
+	UINT8 found = 0;
+	bool valid = true;
+	int fields;
+
+	file = fopen(path, "r");
+	if (file == NULL)
+		return -1;
+
+	while (valid && (fields = fscanf(file, "%15s %i", name, &value)) == 2) {
+		if (strcmp(name, "timing") == 0) {
+			valid = (value & ~TCS3414_INTEG_MASK) == 0 && value != 0x03;
+			loaded.timing = value;
+			found |= 0x01;
+		} else if (strcmp(name, "gain") == 0) {
+			valid = (value & ~TCS3414_GAIN_MASK) == 0;
+			loaded.gain = value;
+			found |= 0x02;
+		}
+	}
+	fclose(file);
+
+	/* fscanf() ends with EOF only at the end of a complete file */
+	if (!valid || fields != EOF || found != 0x03)
+		return -1;
+	*config = loaded;
+	return 0;
+}
+
+/************************************************************************/
+/* Save the configuration												*/
+/************************************************************************/
+
+INT16 sensor_state_save(const char *path, const TCS3414_Config *config) {
+	char tmp[256];
+	FILE *file;
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+	file = fopen(tmp, "w");
+	if (file == NULL) {
+		perror("sensorStateSave");
+		return -1;
+	}
+
+	fprintf(file, "timing 0x%02x\ngain 0x%02x\n", config->timing, config->gain);
+
+	if (fclose(file) != 0 || rename(tmp, path) != 0) {
+		perror("sensorStateSave");
+		remove(tmp);
+		return -1;
+	}
+	return 0;
+}
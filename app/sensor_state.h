@@ -0,0 +1,35 @@
+/*
+ ***************************************************************************
+ * \brief   Persisted sensor configuration
+ *	    	Stores the last good integration time and gain of the
+ *	    	TCS3414 in a small text file, so the next start can use
+ *	    	them right away.
+ * \file    sensor_state.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef SENSOR_STATE_H
+#define SENSOR_STATE_H
+
+#include "TCS3414.h"
+
+/* Default location of the state file */
+#define SENSOR_STATE_FILE	"/var/lib/farbsensor.state"
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 sensor_state_load(const char *path, TCS3414_Config *config);
+extern INT16 sensor_state_save(const char *path, const TCS3414_Config *config);
+
+/* #ifndef SENSOR_STATE_H */
+#endif
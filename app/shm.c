@@ -0,0 +1,269 @@
+/*
+ ***************************************************************************
+ * \brief   Shared memory publication of the samples
+ *	    	Writer: bump the slot lock to odd, write the sample, bump it
+ *	    	to even, then publish the new count. Reader: read the lock,
+ *	    	copy the sample, read the lock again; the copy is good if
+ *	    	the lock was even and did not change. The writer never
+ *	    	waits, a reader only repeats a copy that was torn.
+ * \file    shm.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ *          19.10.2026 a segment in use is not taken over
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shm.h"
+
+/* Segment and name of the writer, NULL if nothing is published */
+static ShmSegment *publishSegment;
+static char publishName[64];
+
+/************************************************************************/
+/* An existing segment is stale if its writer no longer runs. A segment	*/
+/* of a running writer or of something else is left alone.				*/
+/************************************************************************/
+
+static bool shm_stale(const char *name) {
+	const ShmSegment *segment;
+	struct stat st;
+	bool stale = false;
+	INT32 pid;
+	int fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return errno == ENOENT;
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(ShmSegment)) {
+		close(fd);
+		fprintf(stderr, "shmOpen: /dev/shm%s exists and is not a sensor "
+				"segment\n", name);
+		return false;
+	}
+
+	segment = mmap(NULL, sizeof(ShmSegment), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED) {
+		perror("shmMmap");
+		return false;
+	}
+
+	pid = segment->pid;
+	if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC)
+		fprintf(stderr, "shmOpen: /dev/shm%s exists and is not a sensor "
+				"segment\n", name);
+	else if (pid > 0 && (kill(pid, 0) == 0 || errno == EPERM))
+		fprintf(stderr, "shmOpen: %s is published by process %d\n", name, pid);
+	else
+		stale = true;
+	munmap((void *) segment, sizeof(ShmSegment));
+	return stale;
+}
+
+/************************************************************************/
+/* Create the segment. A segment left by a writer that no longer runs	*/
+/* is replaced (readers still attached keep the old one), the segment	*/
+/* of a running writer is not.											*/
+/************************************************************************/
+
+INT16 shm_publish_open(const char *name) {
+	ShmSegment *segment;
+	int fd;
+
+	fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0 && errno == EEXIST) {
+		/* shm_stale() says why it is left alone */
+		if (!shm_stale(name))
+			return -1;
+		shm_unlink(name);
+		fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	}
+	if (fd < 0) {
+		perror("shmOpen");
+		return -1;
+	}
+	if (ftruncate(fd, sizeof(ShmSegment)) < 0) {
+		perror("shmTruncate");
+		close(fd);
+		shm_unlink(name);
+		return -1;
+	}
+
+	segment = mmap(NULL, sizeof(ShmSegment), PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED) {
+		perror("shmMmap");
+		shm_unlink(name);
+		return -1;
+	}
+
+	/* the pages are new and zero, touch them now and not in the loop */
+	memset(segment, 0, sizeof(*segment));
+	segment->version = SHM_VERSION;
+	segment->history = SHM_HISTORY;
+	segment->pid = getpid();
+
+	/* readers accept the segment once the magic is there */
+	__atomic_store_n(&segment->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+	strncpy(publishName, name, sizeof(publishName) - 1);
+	publishSegment = segment;
+	return 0;
+}
+
+/************************************************************************/
+/* Publish a sample, does nothing if no segment is open					*/
+/************************************************************************/
+
+void shm_publish(UINT64 timeUs, const UINT16 *color) {
+	ShmSegment *segment = publishSegment;
+	ShmSlot *slot;
+	UINT64 number;
+	UINT32 lock;
+
+	if (segment == NULL)
+		return;
+
+	/* only this thread writes, plain reads of count and lock are fine */
+	number = segment->count;
+	slot = &segment->slot[number & (SHM_HISTORY - 1)];
+	lock = slot->lock;
+
+	__atomic_store_n(&slot->lock, lock + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->sample.number = number;
+	slot->sample.timeUs = timeUs;
+	memcpy(slot->sample.color, color, sizeof(slot->sample.color));
+
+	__atomic_store_n(&slot->lock, lock + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&segment->count, number + 1, __ATOMIC_RELEASE);
+}
+
+/************************************************************************/
+/* Remove the segment													*/
+/************************************************************************/
+
+void shm_publish_close(void) {
+	if (publishSegment == NULL)
+		return;
+
+	munmap(publishSegment, sizeof(ShmSegment));
+	shm_unlink(publishName);
+	publishSegment = NULL;
+}
+
+/************************************************************************/
+/* Map a segment read only												*/
+/************************************************************************/
+
+const ShmSegment *shm_attach(const char *name) {
+	const ShmSegment *segment;
+	struct stat st;
+	int fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		perror("shmAttach");
+		return NULL;
+	}
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t) sizeof(ShmSegment)) {
+		fprintf(stderr, "shmAttach: %s is not a sensor segment\n", name);
+		close(fd);
+		return NULL;
+	}
+
+	segment = mmap(NULL, sizeof(ShmSegment), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (segment == MAP_FAILED) {
+		perror("shmMmap");
+		return NULL;
+	}
+
+	if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC
+			|| segment->version != SHM_VERSION
+			|| segment->history != SHM_HISTORY) {
+		fprintf(stderr, "shmAttach: %s has an unknown layout\n", name);
+		munmap((void *) segment, sizeof(ShmSegment));
+		return NULL;
+	}
+	return segment;
+}
+
+void shm_detach(const ShmSegment *segment) {
+	if (segment != NULL)
+		munmap((void *) segment, sizeof(ShmSegment));
+}
+
+/************************************************************************
+ * Read sample number from the ring. Returns 0, -ENOENT if the slot
+ * holds another sample (not yet published or already overwritten) or
+ * -EAGAIN if the writer tore every copy. stats may be NULL.
+ ************************************************************************/
+
+INT16 shm_read_sample(const ShmSegment *segment, UINT64 number,
+		ShmSample *sample, ShmReadStats *stats) {
+	const ShmSlot *slot = &segment->slot[number & (SHM_HISTORY - 1)];
+	ShmReadStats unused;
+	ShmSample copy;
+	UINT32 lock, tries;
+
+	if (stats == NULL)
+		stats = &unused;
+
+	for (tries = 0; tries < SHM_READ_TRIES; tries++) {
+		lock = __atomic_load_n(&slot->lock, __ATOMIC_ACQUIRE);
+		if ((lock & 1) == 0) {
+			copy = slot->sample;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&slot->lock, __ATOMIC_RELAXED) == lock) {
+				stats->reads++;
+				if (copy.number != number || lock == 0)
+					return -ENOENT;
+				*sample = copy;
+				return 0;
+			}
+		}
+		stats->retries++;
+	}
+	stats->failed++;
+	return -EAGAIN;
+}
+
+/************************************************************************/
+/* Read the newest sample, -ENOENT if nothing was published yet			*/
+/************************************************************************/
+
+INT16 shm_read_latest(const ShmSegment *segment, ShmSample *sample,
+		ShmReadStats *stats) {
+	UINT64 count;
+	INT16 status;
+	UINT32 tries;
+
+	/* the slot is only gone if the writer lapped the whole ring */
+	for (tries = 0; tries < SHM_READ_TRIES; tries++) {
+		count = __atomic_load_n(&segment->count, __ATOMIC_ACQUIRE);
+		if (count == 0)
+			return -ENOENT;
+
+		status = shm_read_sample(segment, count - 1, sample, stats);
+		if (status != -ENOENT)
+			return status;
+	}
+	return -EAGAIN;
+}
@@ -0,0 +1,93 @@
+/*
+ ***************************************************************************
+ * \brief   Shared memory publication of the samples
+ *	    	The acquisition publishes every sample into a POSIX shared
+ *	    	memory segment: a ring of the last samples, each slot guarded
+ *	    	by its own seqlock. Readers map the segment read only, they
+ *	    	never write to it and never block the writer. The latest
+ *	    	sample is the slot of the newest sample number.
+ * \file    shm.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef SHM_H
+#define SHM_H
+
+#include "TCS3414.h"
+
+/* Name of the segment (/dev/shm/farbsensor) */
+#define SHM_NAME		"/farbsensor"
+
+/* Layout of the segment, readers check both */
+#define SHM_MAGIC		0x54435334	/* "TCS4" */
+#define SHM_VERSION		1
+
+/* Samples kept in the ring, a power of two */
+#define SHM_HISTORY		256
+
+/* A reader gives up after this many torn reads of one slot */
+#define SHM_READ_TRIES		64
+
+#define SHM_CACHE_LINE		64
+
+/* A sample as the readers get it */
+typedef struct {
+	UINT64 number;		/* 0 for the first sample published */
+	UINT64 timeUs;		/* CLOCK_MONOTONIC, see i2c_now_us() */
+	UINT16 color[4];	/* indexed by Color */
+} ShmSample;
+
+/* Slot of the ring, the lock is odd while the writer is in it */
+typedef struct {
+	UINT32    lock;
+	UINT32    reserved;
+	ShmSample sample;
+} ShmSlot;
+
+typedef struct {
+	/* written once by the writer before the first sample */
+	UINT32 magic;
+	UINT32 version;
+	UINT32 history;
+	INT32  pid;		/* of the writer */
+
+	/* samples published so far, the newest is count - 1 */
+	UINT64 count __attribute__((aligned(SHM_CACHE_LINE)));
+
+	ShmSlot slot[SHM_HISTORY] __attribute__((aligned(SHM_CACHE_LINE)));
+} ShmSegment;
+
+/* Reader side statistics */
+typedef struct {
+	UINT64 reads;
+	UINT64 retries;		/* torn reads that were repeated */
+	UINT64 failed;		/* reads that gave up */
+} ShmReadStats;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+/* writer, one per segment */
+extern INT16 shm_publish_open(const char *name);
+extern void  shm_publish(UINT64 timeUs, const UINT16 *color);
+extern void  shm_publish_close(void);
+
+/* readers */
+extern const ShmSegment *shm_attach(const char *name);
+extern void  shm_detach(const ShmSegment *segment);
+extern INT16 shm_read_latest(const ShmSegment *segment, ShmSample *sample,
+		ShmReadStats *stats);
+extern INT16 shm_read_sample(const ShmSegment *segment, UINT64 number,
+		ShmSample *sample, ShmReadStats *stats);
+
+/* #ifndef SHM_H */
+#endif
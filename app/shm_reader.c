@@ -0,0 +1,230 @@
+/*
+ ***************************************************************************
+ * \brief   Example reader of the shared memory samples and benchmark
+ * \file    shm_reader.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "shm_reader.h"
+
+/* Reads between two looks at the clock */
+#define SHM_CLOCK_INTERVAL	1024
+
+/************************************************************************/
+/* Print one sample as CSV												*/
+/************************************************************************/
+
+static void shm_print_sample(FILE *out, const ShmSample *sample) {
+	fprintf(out, "%llu,%llu,%u,%u,%u,%u\n", sample->number, sample->timeUs,
+			sample->color[GREEN], sample->color[RED], sample->color[BLUE],
+			sample->color[CLEAR]);
+}
+
+/************************************************************************
+ * Example reader: follow the segment for some seconds and print every
+ * new sample to out. It polls the latest sample as fast as it can;
+ * samples that came in between two polls are taken from the ring.
+ ************************************************************************/
+
+INT16 shm_reader_run(FILE *out, const char *name, FLOAT64 seconds) {
+	const ShmSegment *segment;
+	ShmReadStats stats;
+	ShmSample sample, missed;
+	UINT64 start, end, now, last = 0, number;
+	UINT64 samples = 0, fromRing = 0, lost = 0;
+	bool seen = false;
+	UINT32 i;
+
+	segment = shm_attach(name);
+	if (segment == NULL)
+		return -1;
+
+	memset(&stats, 0, sizeof(stats));
+	fprintf(out, "number,time_us,green,red,blue,clear\n");
+
+	start = now = i2c_now_us();
+	end = start + (UINT64) (seconds * 1e6);
+	while (now < end) {
+		for (i = 0; i < SHM_CLOCK_INTERVAL; i++) {
+			if (shm_read_latest(segment, &sample, &stats) < 0
+					|| (seen && sample.number == last))
+				continue;
+
+			/* everything between the last and this one is in the ring */
+			for (number = last + 1; seen && number < sample.number; number++) {
+				if (shm_read_sample(segment, number, &missed, &stats) == 0) {
+					shm_print_sample(out, &missed);
+					fromRing++;
+				} else
+					lost++;
+			}
+
+			shm_print_sample(out, &sample);
+			samples++;
+			last = sample.number;
+			seen = true;
+		}
+		now = i2c_now_us();
+	}
+	fflush(out);
+
+	fprintf(stderr, "reader: %llu reads, %.2f M reads/s, %llu retries, "
+			"%llu failed\n", stats.reads, stats.reads / (FLOAT64) (now - start),
+			stats.retries, stats.failed);
+	fprintf(stderr, "reader: %llu samples, %llu from the ring, %llu lost\n",
+			samples + fromRing, fromRing, lost);
+
+	shm_detach(segment);
+	return 0;
+}
+
+/*
+ ***************************************************************************
+ * Benchmark
+ ***************************************************************************
+ */
+
+typedef struct {
+	const ShmSegment *segment;
+	ShmReadStats stats;
+	pthread_t thread;
+} ShmBenchReader;
+
+static volatile int shmBenchStop;
+
+/************************************************************************/
+/* Reader thread: read the latest sample until stopped					*/
+/************************************************************************/
+
+static void *shm_bench_reader(void *arg) {
+	ShmBenchReader *reader = arg;
+	ShmSample sample;
+
+	while (!__atomic_load_n(&shmBenchStop, __ATOMIC_RELAXED))
+		shm_read_latest(reader->segment, &sample, &reader->stats);
+	return NULL;
+}
+
+/************************************************************************/
+/* Publish as fast as possible, returns ns per publication				*/
+/************************************************************************/
+
+static FLOAT64 shm_bench_writer(FLOAT64 seconds) {
+	UINT16 color[4] = { 0, 0, 0, 0 };
+	UINT64 start, now, end, publishes = 0;
+	UINT32 i;
+
+	start = now = i2c_now_us();
+	end = start + (UINT64) (seconds * 1e6);
+	while (now < end) {
+		for (i = 0; i < SHM_CLOCK_INTERVAL; i++) {
+			color[CLEAR]++;
+			shm_publish(now, color);
+		}
+		publishes += SHM_CLOCK_INTERVAL;
+		now = i2c_now_us();
+	}
+	return (now - start) * 1000.0 / publishes;
+}
+
+/************************************************************************/
+/* Sum of the reads of all readers										*/
+/************************************************************************/
+
+static void shm_bench_sum(ShmBenchReader *reader, UINT32 readers,
+		ShmReadStats *sum) {
+	UINT32 i;
+
+	memset(sum, 0, sizeof(*sum));
+	for (i = 0; i < readers; i++) {
+		sum->reads += __atomic_load_n(&reader[i].stats.reads, __ATOMIC_RELAXED);
+		sum->retries += __atomic_load_n(&reader[i].stats.retries,
+				__ATOMIC_RELAXED);
+		sum->failed += __atomic_load_n(&reader[i].stats.failed,
+				__ATOMIC_RELAXED);
+	}
+}
+
+/************************************************************************
+ * Benchmark on a segment of its own: the writer alone, the writer with
+ * readers hammering the segment, and the readers with an idle writer
+ * (the usual case, the sensor delivers a sample every few ms).
+ ************************************************************************/
+
+INT16 shm_bench(FILE *out, UINT32 readers, FLOAT64 seconds) {
+	ShmBenchReader reader[readers ? readers : 1];
+	ShmReadStats busy, idle;
+	FLOAT64 alone, loaded;
+	UINT64 startUs, busyUs, idleUs;
+	UINT32 i, started = 0;
+	INT16 status = 0;
+
+	if (seconds <= 0)
+		seconds = SHM_BENCH_SECONDS;
+	if (shm_publish_open(SHM_BENCH_NAME) < 0)
+		return -1;
+
+	alone = shm_bench_writer(seconds);
+
+	memset(reader, 0, sizeof(reader));
+	shmBenchStop = 0;
+	for (i = 0; i < readers; i++) {
+		reader[i].segment = shm_attach(SHM_BENCH_NAME);
+		if (reader[i].segment == NULL
+				|| pthread_create(&reader[i].thread, NULL, shm_bench_reader,
+						&reader[i]) != 0) {
+			shm_detach(reader[i].segment);
+			status = -1;
+			break;
+		}
+		started++;
+	}
+
+	if (status == 0) {
+		startUs = i2c_now_us();
+		loaded = shm_bench_writer(seconds);
+		busyUs = i2c_now_us() - startUs;
+		shm_bench_sum(reader, readers, &busy);
+
+		startUs = i2c_now_us();
+		usleep((useconds_t) (seconds * 1e6));
+		idleUs = i2c_now_us() - startUs;
+		shm_bench_sum(reader, readers, &idle);
+		idle.reads -= busy.reads;
+	}
+
+	__atomic_store_n(&shmBenchStop, 1, __ATOMIC_RELAXED);
+	for (i = 0; i < started; i++) {
+		pthread_join(reader[i].thread, NULL);
+		shm_detach(reader[i].segment);
+	}
+	shm_publish_close();
+
+	if (status < 0) {
+		fprintf(out, "shm: could not start %u readers\n", readers);
+		return status;
+	}
+
+	fprintf(out, "shm: writer alone          %7.1f ns per sample\n", alone);
+	fprintf(out, "shm: writer, %3u readers   %7.1f ns per sample\n", readers,
+			loaded);
+	if (readers) {
+		fprintf(out, "shm: busy writer: %.2f M reads/s per reader, "
+				"%llu retries, %llu failed\n",
+				busy.reads / (FLOAT64) busyUs / readers, busy.retries,
+				busy.failed);
+		fprintf(out, "shm: idle writer: %.2f M reads/s per reader\n",
+				idle.reads / (FLOAT64) idleUs / readers);
+	}
+	return 0;
+}
@@ -0,0 +1,41 @@
+/*
+ ***************************************************************************
+ * \brief   Example reader of the shared memory samples and benchmark
+ *	    	The reader shows how a local daemon follows the sensor: it
+ *	    	polls the latest sample and takes the samples it missed from
+ *	    	the ring. The benchmark measures the reads per second and
+ *	    	what the readers cost the writer.
+ * \file    shm_reader.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef SHM_READER_H
+#define SHM_READER_H
+
+#include <stdio.h>
+
+#include "shm.h"
+
+/* Segment of the benchmark, the one of a running sensor is left alone */
+#define SHM_BENCH_NAME		"/farbsensor-bench"
+
+/* Length of every benchmark phase */
+#define SHM_BENCH_SECONDS	1.0
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern INT16 shm_reader_run(FILE *out, const char *name, FLOAT64 seconds);
+extern INT16 shm_bench(FILE *out, UINT32 readers, FLOAT64 seconds);
+
+/* #ifndef SHM_READER_H */
+#endif
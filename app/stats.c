@@ -0,0 +1,246 @@
+/*
+ ***************************************************************************
+ * \brief   Online per-channel statistics
+ *	    	The window is a ring of slots. A sample goes into the total
+ *	    	and into the current slot; when a slot is full the oldest
+ *	    	one is cleared and becomes the current one. The window is
+ *	    	the merge of all slots.
+ * \file    stats.c
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "stats.h"
+
+/************************************************************************/
+/* Sketch bucket of a value												*/
+/************************************************************************/
+
+static UINT32 stats_bucket(UINT16 value) {
+	UINT32 msb;
+
+	if (value < STATS_SUB_BUCKETS)
+		return value;
+
+	msb = 31 - __builtin_clz(value);
+	return STATS_SUB_BUCKETS * (msb - STATS_SUB_BITS + 1)
+			+ ((value >> (msb - STATS_SUB_BITS)) & (STATS_SUB_BUCKETS - 1));
+}
+
+/************************************************************************/
+/* Value in the middle of a sketch bucket								*/
+/************************************************************************/
+
+static UINT16 stats_bucket_value(UINT32 bucket) {
+	UINT32 shift, lower;
+
+	if (bucket < STATS_SUB_BUCKETS)
+		return bucket;
+
+	shift = bucket / STATS_SUB_BUCKETS - 1;
+	lower = (STATS_SUB_BUCKETS + bucket % STATS_SUB_BUCKETS) << shift;
+	return lower + ((1 << shift) >> 1);
+}
+
+/************************************************************************/
+/* Add one value to a channel (Welford update)							*/
+/************************************************************************/
+
+static void stats_channel_add(StatsChannel *channel, UINT16 value) {
+	StatsMoments *m = &channel->moments;
+	FLOAT64 delta;
+
+	if (m->count == 0 || value < m->min)
+		m->min = value;
+	if (m->count == 0 || value > m->max)
+		m->max = value;
+
+	m->count++;
+	delta = value - m->mean;
+	m->mean += delta / m->count;
+	m->m2 += delta * (value - m->mean);
+
+	channel->bucket[stats_bucket(value)]++;
+}
+
+/************************************************************************/
+/* Empty all channels of a set											*/
+/************************************************************************/
+
+void stats_clear(StatsSet *set) {
+	memset(set, 0, sizeof(*set));
+}
+
+/************************************************************************/
+/* Start the statistics of a sensor										*/
+/************************************************************************/
+
+void stats_init(Stats *stats, UINT32 windowSeconds) {
+	memset(stats, 0, sizeof(*stats));
+
+	if (windowSeconds == 0)
+		windowSeconds = STATS_WINDOW_SECONDS;
+	stats->slotUs = windowSeconds * 1000000ULL / STATS_WINDOW_SLOTS;
+}
+
+/************************************************************************/
+/* Move the window forward to a point in time							*/
+/************************************************************************/
+
+static void stats_advance(Stats *stats, UINT64 timeUs) {
+	UINT32 i;
+
+	if (stats->slotStart == 0)
+		stats->slotStart = timeUs;
+
+	for (i = 0; timeUs >= stats->slotStart + stats->slotUs; i++) {
+		stats->slotStart += stats->slotUs;
+
+		/* after a long gap all slots are simply empty */
+		if (i < STATS_WINDOW_SLOTS) {
+			stats->current = (stats->current + 1) % STATS_WINDOW_SLOTS;
+			stats_clear(&stats->slot[stats->current]);
+		} else {
+			stats->slotStart += (timeUs - stats->slotStart)
+					/ stats->slotUs * stats->slotUs;
+		}
+	}
+}
+
+/************************************************************************/
+/* Add one sample of all four channels									*/
+/************************************************************************/
+
+void stats_add(Stats *stats, UINT64 timeUs, const UINT16 *color) {
+	StatsSet *slot;
+	UINT32 i;
+
+	stats_advance(stats, timeUs);
+	slot = &stats->slot[stats->current];
+
+	for (i = 0; i < 4; i++) {
+		stats_channel_add(&stats->total.channel[i], color[i]);
+		stats_channel_add(&slot->channel[i], color[i]);
+	}
+}
+
+/************************************************************************/
+/* Merge two sets (Chan et al. for the moments, sum of the buckets)		*/
+/************************************************************************/
+
+void stats_merge(StatsSet *into, const StatsSet *from) {
+	UINT32 i, b;
+
+	for (i = 0; i < 4; i++) {
+		StatsMoments *a = &into->channel[i].moments;
+		const StatsMoments *m = &from->channel[i].moments;
+		FLOAT64 delta;
+		UINT64 count;
+
+		if (m->count == 0)
+			continue;
+
+		if (a->count == 0) {
+			into->channel[i] = from->channel[i];
+			continue;
+		}
+
+		count = a->count + m->count;
+		delta = m->mean - a->mean;
+		a->mean += delta * m->count / count;
+		a->m2 += m->m2 + delta * delta * a->count * m->count / count;
+		a->count = count;
+		if (m->min < a->min)
+			a->min = m->min;
+		if (m->max > a->max)
+			a->max = m->max;
+
+		for (b = 0; b < STATS_SKETCH_BUCKETS; b++)
+			into->channel[i].bucket[b] += from->channel[i].bucket[b];
+	}
+}
+
+/************************************************************************/
+/* Statistics of the last window up to nowUs							*/
+/************************************************************************/
+
+void stats_window(Stats *stats, UINT64 nowUs, StatsSet *window) {
+	UINT32 i;
+
+	stats_advance(stats, nowUs);
+
+	stats_clear(window);
+	for (i = 0; i < STATS_WINDOW_SLOTS; i++)
+		stats_merge(window, &stats->slot[i]);
+}
+
+/************************************************************************/
+/* Sample variance of a channel											*/
+/************************************************************************/
+
+FLOAT64 stats_variance(const StatsChannel *channel) {
+	if (channel->moments.count < 2)
+		return 0.0;
+	return channel->moments.m2 / (channel->moments.count - 1);
+}
+
+/************************************************************************/
+/* Quantile q (0..1) of a channel										*/
+/************************************************************************/
+
+UINT16 stats_quantile(const StatsChannel *channel, FLOAT64 q) {
+	const StatsMoments *m = &channel->moments;
+	UINT64 rank, seen = 0;
+	UINT32 b;
+	UINT16 value;
+
+	if (m->count == 0)
+		return 0;
+
+	rank = (UINT64) (q * (m->count - 1) + 0.5);
+	for (b = 0; b < STATS_SKETCH_BUCKETS; b++) {
+		seen += channel->bucket[b];
+		if (seen > rank)
+			break;
+	}
+
+	/* the exact extremes are known */
+	value = stats_bucket_value(b);
+	if (value < m->min)
+		value = m->min;
+	if (value > m->max)
+		value = m->max;
+	return value;
+}
+
+/************************************************************************/
+/* Print a set as a table, one line per channel							*/
+/************************************************************************/
+
+void stats_print(FILE *out, const char *title, const StatsSet *set) {
+	static const char *names[4] = { "GREEN", "RED  ", "BLUE ", "CLEAR" };
+	UINT32 i;
+
+	fprintf(out, "%s (%llu samples)\n", title,
+			set->channel[GREEN].moments.count);
+	fprintf(out, "       mean     stddev   min    p5     p50    p95    "
+			"p99    max\n");
+
+	for (i = 0; i < 4; i++) {
+		const StatsChannel *c = &set->channel[i];
+
+		fprintf(out, "%s  %-8.1f %-8.2f %-6u %-6u %-6u %-6u %-6u %u\n",
+				names[i], c->moments.mean, sqrt(stats_variance(c)),
+				c->moments.min, stats_quantile(c, 0.05),
+				stats_quantile(c, 0.50), stats_quantile(c, 0.95),
+				stats_quantile(c, 0.99), c->moments.max);
+	}
+}
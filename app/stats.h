@@ -0,0 +1,85 @@
+/*
+ ***************************************************************************
+ * \brief   Online per-channel statistics
+ *	    	Mean, variance, min and max (Welford) and quantiles (log
+ *	    	bucketed histogram) of the four color channels. Memory is
+ *	    	constant however long the run is, adding a sample is O(1)
+ *	    	and two sets can be merged, e.g. the slots of the window or
+ *	    	the statistics of several sensors.
+ * \file    stats.h
+ * \version 1.0
+ * \date    19.10.2026
+ * \author  Cyril Stoller
+ *
+ * \remark  Last Modifications:
+ *          19.10.2026 created
+ ***************************************************************************
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+#include "TCS3414.h"
+
+/*
+ * Quantile sketch: values below 32 have a bucket each, every power of
+ * two above is split into 32 buckets. The relative error of a quantile
+ * is below 1/64 over the whole 16 bit range.
+ */
+#define STATS_SUB_BITS		5
+#define STATS_SUB_BUCKETS	(1 << STATS_SUB_BITS)
+#define STATS_SKETCH_BUCKETS	(STATS_SUB_BUCKETS * (16 - STATS_SUB_BITS + 1))
+
+/* The window is kept as this many slots of window/slots each */
+#define STATS_WINDOW_SLOTS	10
+
+/* Default length of the window in seconds */
+#define STATS_WINDOW_SECONDS	10
+
+/* Welford accumulator */
+typedef struct {
+	UINT64  count;
+	FLOAT64 mean;
+	FLOAT64 m2;		/* sum of squared differences from the mean */
+	UINT16  min;
+	UINT16  max;
+} StatsMoments;
+
+typedef struct {
+	StatsMoments moments;
+	UINT32 bucket[STATS_SKETCH_BUCKETS];
+} StatsChannel;
+
+/* Statistics of all four channels, indexed by Color */
+typedef struct {
+	StatsChannel channel[4];
+} StatsSet;
+
+/* Statistics of one sensor: the whole run and the last window */
+typedef struct {
+	StatsSet total;
+	StatsSet slot[STATS_WINDOW_SLOTS];
+	UINT32   slotUs;
+	UINT32   current;
+	UINT64   slotStart;
+} Stats;
+
+/*
+ ***************************************************************************
+ *  Prototypes
+ ***************************************************************************
+ */
+
+extern void    stats_init(Stats *stats, UINT32 windowSeconds);
+extern void    stats_add(Stats *stats, UINT64 timeUs, const UINT16 *color);
+extern void    stats_window(Stats *stats, UINT64 nowUs, StatsSet *window);
+extern void    stats_clear(StatsSet *set);
+extern void    stats_merge(StatsSet *into, const StatsSet *from);
+extern FLOAT64 stats_variance(const StatsChannel *channel);
+extern UINT16  stats_quantile(const StatsChannel *channel, FLOAT64 q);
+extern void    stats_print(FILE *out, const char *title, const StatsSet *set);
+
+/* #ifndef STATS_H */
+#endif